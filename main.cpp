@@ -1,7 +1,7 @@
 #include "mbed.h"
+#include <sys/stat.h>
 #include "EasyAttach_CameraAndLCD.h"
-#include "dcache-control.h"
-#include "AsciiFont.h"
+#include "SdUsbConnect.h"
 #include "r_dk2_if.h"
 #include "r_drp_bayer2grayscale.h"
 #include "r_drp_image_rotate.h"
@@ -19,11 +19,30 @@
 #include "r_drp_cropping.h"
 #include "r_drp_resize_bilinear_fixed.h"
 #include "r_drp_histogram_normalization.h"
+#include "overlay_compositor.h"
+#include "blob_labeling.h"
+#include "image_view.h"
+#include "resize_bilinear.h"
+#include "temporal_filter.h"
+#include "buffer_owner.h"
+#include "drp_job.h"
+#include "drp_trace.h"
+#include "config_memory.h"
+#include "memory_tier.h"
+#include "pgm_file.h"
+#include "histogram.h"
+#include "pyramid.h"
+#include "param_store.h"
+#include "integral_image.h"
 
 #define RAM_TABLE_DYNAMIC_LOADING   1
 // 0: Use the configuration data stored in ROM directly.
 // 1: Deploy configuration data to RAM to speed up loading to DRP.
 
+#ifndef MBED_CONF_APP_DRP_CONFIG_MEMORY_SIZE
+#define MBED_CONF_APP_DRP_CONFIG_MEMORY_SIZE   (800 * 1024)
+#endif
+
 /*! Frame buffer stride: Frame buffer stride should be set to a multiple of 32 or 128
     in accordance with the frame buffer burst transfer mode. */
 #define VIDEO_PIXEL_HW         (640)
@@ -32,19 +51,73 @@
 #define DATA_SIZE_PER_PIC      (1u)
 #define FRAME_BUFFER_STRIDE    (((VIDEO_PIXEL_HW * DATA_SIZE_PER_PIC) + 31u) & ~31u)
 #define FRAME_BUFFER_HEIGHT    (VIDEO_PIXEL_VW)
+#define FRAME_BUFFER_SIZE      (FRAME_BUFFER_STRIDE * FRAME_BUFFER_HEIGHT)
+
+// The CPU state of a mode and the work buffers of its frame slots after the first are carved from one arena
+#ifndef MBED_CONF_APP_STATE_ARENA_SIZE
+#define MBED_CONF_APP_STATE_ARENA_SIZE   (VIDEO_PIXEL_HW * VIDEO_PIXEL_VW * 4)
+#endif
+#define CPU_STATE_SIZE         (MBED_CONF_APP_STATE_ARENA_SIZE)
+
+// Capacity of the memory tiers the work buffers and the CPU state are placed in.
+// By default all of them fit in on-chip RAM.
+#ifndef MBED_CONF_APP_TIER_OCRAM_SIZE
+#define MBED_CONF_APP_TIER_OCRAM_SIZE    ((FRAME_BUFFER_SIZE * 2) + CPU_STATE_SIZE)
+#endif
+#ifndef MBED_CONF_APP_TIER_EXTRAM_SIZE
+#define MBED_CONF_APP_TIER_EXTRAM_SIZE   (0)
+#endif
 
-#define DRP_FLG_TILE_ALL       (R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5)
 #define DRP_FLG_CAMER_IN       (0x00000100)
+#define DRP_FLG_BLOB_DONE      (0x00000200)
+#define DRP_FLG_CPU_DONE       (0x00000400)
+#define DRP_FLG_JOB_DONE0      (0x00000800)
+#define DRP_FLG_FLIP           (0x00001000)
+#define DRP_FLG_JOB_DONE1      (0x00002000)
+
+#define CPU_FLG_START          (0x00000001)
+
+#define BLOB_FLG_START         (0x00000001)
+#define BLOB_MIN_AREA          (16)
+#define BLOB_DRAW_MAX          (32)
 
 #define DRP_LIB_MAX            (10)
+#ifndef MBED_CONF_APP_FRAME_IN_FLIGHT_MAX
+#define MBED_CONF_APP_FRAME_IN_FLIGHT_MAX    (3)
+#endif
+#define FRAME_IN_FLIGHT_MAX    (MBED_CONF_APP_FRAME_IN_FLIGHT_MAX)
+#define STREAM_MAX             (2)
+
+#define TILE_GROUP_ALL         (R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5)
+#define TILE_GROUP_0           (R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2)
+#define TILE_GROUP_1           (R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5)
+
+#define FRAME_VIEW(buf)        image_view(buf, VIDEO_PIXEL_HW, VIDEO_PIXEL_VW, FRAME_BUFFER_STRIDE)
 
 typedef struct {
-    uint32_t  drp_lib_no;
-    uint8_t * p_drp_lib_bin;
-    uint8_t * src;
-    uint8_t * dst;
-    uint32_t  load_time;
-    uint32_t  run_time;
+    uint32_t      drp_lib_no;
+    uint8_t *     p_drp_lib_bin;
+    image_view_t  src;
+    image_view_t  dst;
+    image_view_t  src_view;     // Strided source to be packed into src before running (base is NULL if not used)
+    image_view_t  work;         // Work area of the DRP library in the state arena (base is NULL if not used)
+    uint8_t *     p_drp_sub_bin;
+    config_handle_t lib_handle; // Configuration data in RAM, p_drp_lib_bin/p_drp_sub_bin are resolved at start
+    config_handle_t sub_handle;
+    temporal_state_t * p_temporal;  // Per-pixel state kept across frames (NULL if not used)
+    image_view_t  guide;        // Coarse result selecting the stripes to run (base is NULL if all run)
+    uint32_t      stripe_mask;  // Stripes run by the stage, bit n is tile n
+    bool          cpu_resize;   // The ratio is not supported by the DRP library, resized on the CPU instead
+    uint32_t      tiles;        // Tile group of the stream, bit n is tile n
+    uint32_t      run_start;    // exec_timer at the start of the run (us)
+    uint32_t      timeout_us;   // Run time after which the stage is taken as stalled
+    bool          stalled;      // A wait inside the stage function has timed out
+    const param_set_t * p_param;  // Parameters latched at the start of the frame
+    drp_job_t     job;          // Last phase of the stage, still running when the stage function returns
+    uint32_t      load_num;     // R_DK2_Load calls of the stage
+    uint32_t      pack_time;
+    uint32_t      load_time;
+    uint32_t      run_time;
 } drp_lib_ctl_t;
 
 typedef void (*drp_func_t)(drp_lib_ctl_t * p_drp_lib_ctl);
@@ -54,34 +127,125 @@ typedef struct {
     const char *    lib_name;
     const uint8_t * lib_bin;
     uint32_t        lib_bin_size;
+    bool            src_stride;     // true: The library can read a source view with any stride
+    bool            tile_group;     // true: One-tile circuits striped over any tile group
+    uint32_t        sub_lib_no;     // Second library loaded next to the first one (DRP_LIB_NONE if not used)
+    uint8_t         state_bpp;      // Bytes per pixel of state kept across frames (0: stateless)
 } drp_lib_func;
 
-static drp_lib_ctl_t drp_lib[DRP_LIB_MAX];
+typedef struct {
+    drp_lib_ctl_t ctl[DRP_LIB_MAX];  // Stage list with this slot's intermediate buffers
+    uint32_t      frame_no;
+    uint32_t      stage[STREAM_MAX];  // Next stage to run in each stream
+    uint32_t      start_time;        // exec_timer at the start of the first stage (us)
+    uint32_t      capture_seq;       // Stamp of the camera field the frame was taken from (0: not from the camera)
+    uint32_t      capture_time;
+    param_set_t   param;             // Parameters of the frame, the stages see no update while it is in flight
+    bool          active;
+    bool          running[STREAM_MAX];  // The stage is being executed by the DRP or the CPU
+    bool          skipped;           // A stream dropped its stages after a stall, the frame is not shown
+} frame_slot_t;
+
+// The stages of a mode form one stream on the whole array, or several streams on disjoint
+// tile groups. The streams of a frame run side by side, each on its own part of the frame.
+typedef struct {
+    uint32_t      first;             // Stages first to end - 1 of the stage list
+    uint32_t      end;
+    uint32_t      tiles;             // Tile group of the DRP stages
+    uint32_t      job_flg;           // Set on drpTask when the DRP stage of the stream finishes
+    frame_slot_t * drp_slot;         // Frame whose DRP stage is running (NULL if none)
+    uint32_t      latency;           // us, running average from the start of the frame to the end of the stream
+    uint32_t      period;            // us, running average
+    uint32_t      last_done;
+    uint32_t      frames;
+    uint32_t      retry;             // Stalls of the stage running now
+} stream_t;
+
+static drp_lib_ctl_t drp_lib[DRP_LIB_MAX];  // Stage list built for the mode, copied into every frame slot
+static temporal_state_t temporal_state[DRP_LIB_MAX];
+static frame_slot_t frame_slot[FRAME_IN_FLIGHT_MAX];
+static uint32_t stage_next_frame[DRP_LIB_MAX];  // Frame allowed to run each stage next, so stages see frames in order
+static stream_t stream[STREAM_MAX] = {
+    {0, 0, TILE_GROUP_ALL, DRP_FLG_JOB_DONE0, NULL, 0, 0, 0, 0, 0},
+    {0, 0, TILE_GROUP_1,   DRP_FLG_JOB_DONE1, NULL, 0, 0, 0, 0, 0},
+};
+static uint32_t stream_num = 1;
 
 static DisplayBase Display;
 static uint8_t fbuf_bayer[FRAME_BUFFER_STRIDE * FRAME_BUFFER_HEIGHT]__attribute((aligned(128)));
-static uint8_t fbuf_work0[FRAME_BUFFER_STRIDE * FRAME_BUFFER_HEIGHT]__attribute((aligned(32)));
-static uint8_t fbuf_work1[FRAME_BUFFER_STRIDE * FRAME_BUFFER_HEIGHT]__attribute((aligned(32)));
+static uint8_t * fbuf_work0;     // Placed in a memory tier on every mode change
+static uint8_t * fbuf_work1;
+static uint8_t * slot_work[FRAME_IN_FLIGHT_MAX][2];  // fbuf_work0 and fbuf_work1 of each frame slot, copies in the state arena after slot 0
+static uint8_t tier_ocram[MBED_CONF_APP_TIER_OCRAM_SIZE]__attribute((aligned(32)));
+#if MBED_CONF_APP_TIER_EXTRAM_SIZE > 0
+static uint8_t tier_extram[MBED_CONF_APP_TIER_EXTRAM_SIZE]__attribute((section("OCTA_BSS"),aligned(32)));
+#endif
 static uint8_t fbuf_clat8[FRAME_BUFFER_STRIDE * FRAME_BUFFER_HEIGHT]__attribute((aligned(32)));
 static uint8_t fbuf_overlay[FRAME_BUFFER_STRIDE * FRAME_BUFFER_HEIGHT]__attribute((section("NC_BSS"),aligned(32)));
-static uint8_t drp_work_buf[FRAME_BUFFER_STRIDE * (FRAME_BUFFER_HEIGHT + (2 * 3)) * 2]__attribute((section("NC_BSS")));
 static uint8_t nc_memory[512] __attribute((section("NC_BSS")));
 static uint8_t drp_lib_id[R_DK2_TILE_NUM] = {0};
 static Thread drpTask(osPriorityHigh, 1024 * 8);
+static Thread blobTask(osPriorityNormal, 1024 * 4);
+static Thread cpuTask(osPriorityAboveNormal, 1024 * 4);
+static Thread consoleTask(osPriorityBelowNormal, 1024 * 4);
 static uint32_t mode_req = 0;
 static Timer t;
 static Timer event_time;
-static AsciiFont ascii_font(fbuf_overlay, VIDEO_PIXEL_HW, VIDEO_PIXEL_VW, FRAME_BUFFER_STRIDE, DATA_SIZE_PER_PIC);
+static Timer blob_timer;
+static Timer cpu_timer;     // t is used by drpTask only, CPU stages are timed with this one
+static Timer exec_timer;
 static InterruptIn button(USER_BUTTON0);
+static bool blob_labeling_mode = false;
+static volatile bool blob_busy = false;
+static image_view_t blob_view;
+static uint32_t blob_time;
+static blob_result_t blob_result;
+static uint32_t frame_depth = 1;
+static volatile bool mode_reload_req = false;          // The current mode is set up again, e.g. for a new depth
+static frame_slot_t * volatile cpu_job = NULL;
+static uint32_t cpu_stream;     // Stream of the stage cpu_job runs
+static uint32_t exec_latency;   // us, running average
+static uint32_t exec_period;    // us, running average
+static uint32_t exec_last_done;
+static drp_lib_ctl_t done_drp_lib[DRP_LIB_MAX];  // Times of the last finished frame, drawn while the DRP runs
+static bool done_draw_req = false;
+
+// Glass-to-glass latency. Every camera field is stamped with exec_timer and a sequence number,
+// which travel with the frame slot up to the first LCD vsync that scans the result out.
+#define LATENCY_CAPTURE_START  0    // End of the camera field -> start of the first stage
+#define LATENCY_PROCESSING     1    // Start of the first stage -> end of the last stage
+#define LATENCY_DISPLAY        2    // End of the last stage -> LCD vsync
+#define LATENCY_TOTAL          3    // End of the camera field -> LCD vsync
+#define LATENCY_NUM            4
+
+typedef struct {
+    uint32_t      capture_seq;
+    uint32_t      capture_time;
+    uint32_t      start_time;
+    uint32_t      done_time;
+} latency_stamp_t;
+
+static volatile uint32_t capture_seq = 0;
+static volatile uint32_t capture_time;
+static latency_stamp_t flip_stamp;          // Frame waiting for the next LCD vsync
+static volatile bool flip_pending = false;
+static latency_stamp_t shown_stamp;         // Frame the last LCD vsync showed, copied together with flip_time
+static volatile uint32_t flip_time;
+static histogram_t latency_hist[LATENCY_NUM];
+static uint32_t latency_dropped;            // Camera fields no frame was started from
+static uint32_t latency_replaced;           // Frames overwritten before the LCD scanned them out
+static uint32_t latency_last_seq;
+static uint32_t glass_latency;              // us, running average of LATENCY_TOTAL
 
 #if RAM_TABLE_DYNAMIC_LOADING
-static uint8_t * drp_work_memory_top;
-static uint8_t drp_lib_work_memory[800 * 1024]__attribute((aligned(32)));
+static uint8_t drp_lib_work_memory[MBED_CONF_APP_DRP_CONFIG_MEMORY_SIZE]__attribute((aligned(32)));
 #endif
+static uint8_t * cpu_state_memory_top;
+static uint8_t * cpu_state_memory;  // CPU_STATE_SIZE bytes, placed in a memory tier
 
 static const uint32_t clut_data_resut[] = {0x00000000, 0xff00ff00};  // ARGB8888
 
-#define DRP_MODE_MAX              12
+#define DRP_MODE_MAX              21
 
 #define DRP_LIB_BAYER2GRAYSCALE    0
 #define DRP_LIB_IMAGEROTATE        1
@@ -99,6 +263,80 @@ static const uint32_t clut_data_resut[] = {0x00000000, 0xff00ff00};  // ARGB8888
 #define DRP_LIB_CROPPING          13
 #define DRP_LIB_RESIZEBILINEARF   14
 #define DRP_LIB_HISTOGRAM         15
+#define DRP_LIB_RUNNINGAVERAGE    16
+#define DRP_LIB_BACKGROUND        17
+#define DRP_LIB_FRAMEDIFF         18
+#define DRP_LIB_PYRAMID           19
+#define DRP_LIB_ADAPTIVETH        20
+#define DRP_LIB_BOXBLUR           21
+#define DRP_LIB_NONE              0xFFFFFFFF
+#define DRP_LIB_NUM               22
+
+#define PARAM_BINARIZATION_TH      0
+#define PARAM_CANNY_TH_HIGH        1
+#define PARAM_CANNY_TH_LOW         2
+#define PARAM_UNSHARP_STRENGTH     3
+#define PARAM_HISTOGRAM_MEAN       4
+#define PARAM_HISTOGRAM_STD        5
+#define PARAM_ADAPTIVE_RADIUS      6
+#define PARAM_ADAPTIVE_OFFSET      7
+#define PARAM_BOX_RADIUS           8
+#define PARAM_NUM                  9
+
+static const param_def_t param_def_tbl[PARAM_NUM] = {
+//   name                 min  max   init
+    {"binarization_th",     0, 255,  100},   // PARAM_BINARIZATION_TH
+    {"canny_th_high",       0, 255, 0x28},   // PARAM_CANNY_TH_HIGH
+    {"canny_th_low",        0, 255, 0x18},   // PARAM_CANNY_TH_LOW
+    {"unsharp_strength",    0, 255,  255},   // PARAM_UNSHARP_STRENGTH
+    {"histogram_mean",      0, 255,  112},   // PARAM_HISTOGRAM_MEAN
+    {"histogram_std",       1, 255,   48},   // PARAM_HISTOGRAM_STD
+    {"adaptive_radius",     1, 255,   15},   // PARAM_ADAPTIVE_RADIUS
+    {"adaptive_offset",  -255, 255,    8},   // PARAM_ADAPTIVE_OFFSET
+    {"box_radius",          0, 255,    4},   // PARAM_BOX_RADIUS
+};
+
+#define MEM_TIER_OCRAM             0    // On-chip RAM
+#define MEM_TIER_EXTRAM            1    // External RAM (OCTA_BSS)
+#define MEM_TIER_CONFIG            2    // drp_lib_work_memory, managed by config_memory
+#define MEM_TIER_ROM               3    // Configuration data used in place
+#define MEM_TIER_NUM               4
+
+#define MEM_ITEM_WORK0             0    // fbuf_work0 - fbuf_work1
+#define MEM_ITEM_STATE             2    // cpu_state_memory, which also holds slot_work of the slots after the first
+#define MEM_ITEM_CONFIG            3    // Configuration data of each library
+#define MEM_ITEM_NUM              (MEM_ITEM_CONFIG + DRP_LIB_NUM)
+
+typedef struct {
+    bool          visited;
+    uint8_t       tier[MEM_ITEM_NUM];   // Placement of the last visit
+    uint32_t      frames;               // Frames the telemetry was taken from
+    uint32_t      access[MEM_ITEM_NUM]; // Bytes per frame, running average
+    uint32_t      predict_prev;         // us per frame, previous placement with the current telemetry
+    uint32_t      predict;              // us per frame, current placement
+    uint32_t      latency_prev;         // Frame latency measured on the previous visit (us)
+    uint32_t      latency;
+} mem_mode_t;
+
+static memory_tier_t mem_tier[MEM_TIER_NUM] = {
+//   name       arena        capacity (bytes)                  probe
+    {"OCRAM",   tier_ocram,  sizeof(tier_ocram),               tier_ocram,          sizeof(tier_ocram),          0, 0},
+#if MBED_CONF_APP_TIER_EXTRAM_SIZE > 0
+    {"EXTRAM",  tier_extram, sizeof(tier_extram),              tier_extram,         sizeof(tier_extram),         0, 0},
+#else
+    {"EXTRAM",  NULL,        0,                                NULL,                0,                           0, 0},
+#endif
+#if RAM_TABLE_DYNAMIC_LOADING
+    {"CONFIG",  NULL,        sizeof(drp_lib_work_memory),      drp_lib_work_memory, sizeof(drp_lib_work_memory), 0, 0},
+#else
+    {"CONFIG",  NULL,        0,                                NULL,                0,                           0, 0},
+#endif
+    {"ROM",     NULL,        0xFFFFFFFF,                       NULL,                0,                           0, 0},
+};
+static memory_item_t mem_item[MEM_ITEM_NUM];
+static mem_mode_t mem_mode[DRP_MODE_MAX + 1];
+static volatile uint8_t depth_req[DRP_MODE_MAX + 1];  // Frames in flight set with the console per mode (0: default of the mode)
+static uint32_t mem_cur_mode = 0xFFFFFFFF;
 
 static void drp_sample_Bayer2Grayscale(drp_lib_ctl_t * drp_lib_ctl);
 static void drp_sample_ImageRotate(drp_lib_ctl_t * drp_lib_ctl);
@@ -116,25 +354,37 @@ static void drp_sample_UnsharpMasking(drp_lib_ctl_t * drp_lib_ctl);
 static void drp_sample_Cropping(drp_lib_ctl_t * drp_lib_ctl);
 static void drp_sample_ResizeBilinearF(drp_lib_ctl_t * drp_lib_ctl);
 static void drp_sample_Histogram(drp_lib_ctl_t * drp_lib_ctl);
+static void cpu_sample_RunningAverage(drp_lib_ctl_t * drp_lib_ctl);
+static void cpu_sample_Background(drp_lib_ctl_t * drp_lib_ctl);
+static void cpu_sample_FrameDiff(drp_lib_ctl_t * drp_lib_ctl);
+static void cpu_sample_Pyramid(drp_lib_ctl_t * drp_lib_ctl);
+static void cpu_sample_AdaptiveTh(drp_lib_ctl_t * drp_lib_ctl);
+static void cpu_sample_BoxBlur(drp_lib_ctl_t * drp_lib_ctl);
 
 static const drp_lib_func drp_lib_func_tbl[] = {
-//   p_func                       lib_name            lib_bin                           lib_bin_size
-    {&drp_sample_Bayer2Grayscale, "Bayer2Grayscale",  g_drp_lib_bayer2grayscale,        sizeof(g_drp_lib_bayer2grayscale)        }, // DRP_LIB_BAYER2GRAYSCALE
-    {&drp_sample_ImageRotate,     "ImageRotate    ",  g_drp_lib_image_rotate,           sizeof(g_drp_lib_image_rotate)           }, // DRP_LIB_IMAGEROTATE
-    {&drp_sample_MedianBlur,      "MedianBlur     ",  g_drp_lib_median_blur,            sizeof(g_drp_lib_median_blur)            }, // DRP_LIB_MEDIANBLUR
-    {&drp_sample_CannyCalculate,  "CannyCalculate ",  g_drp_lib_canny_calculate,        sizeof(g_drp_lib_canny_calculate)        }, // DRP_LIB_CANNYCALCULATE
-    {&drp_sample_CannyHysterisis, "CannyHysterisis",  g_drp_lib_canny_hysterisis,       sizeof(g_drp_lib_canny_hysterisis)       }, // DRP_LIB_CANNYHYSTERISIS
-    {&drp_sample_Binarization,    "Binarization   ",  g_drp_lib_binarization_fixed,     sizeof(g_drp_lib_binarization_fixed)     }, // DRP_LIB_BINARIZATION
-    {&drp_sample_Erode,           "Erode          ",  g_drp_lib_erode,                  sizeof(g_drp_lib_erode)                  }, // DRP_LIB_ERODE
-    {&drp_sample_Dilate,          "Dilate         ",  g_drp_lib_dilate,                 sizeof(g_drp_lib_dilate)                 }, // DRP_LIB_DILATE
-    {&drp_sample_GaussianBlur,    "GaussianBlur   ",  g_drp_lib_gaussian_blur,          sizeof(g_drp_lib_gaussian_blur)          }, // DRP_LIB_GAUSSIANBLUR
-    {&drp_sample_Sobel,           "Sobel          ",  g_drp_lib_sobel,                  sizeof(g_drp_lib_sobel)                  }, // DRP_LIB_SOBEL
-    {&drp_sample_Prewitt,         "Prewitt        ",  g_drp_lib_prewitt,                sizeof(g_drp_lib_prewitt)                }, // DRP_LIB_PREWITT
-    {&drp_sample_Laplacian,       "Laplacian      ",  g_drp_lib_laplacian,              sizeof(g_drp_lib_laplacian)              }, // DRP_LIB_LAPLACIAN
-    {&drp_sample_UnsharpMasking,  "UnsharpMasking ",  g_drp_lib_unsharp_masking,        sizeof(g_drp_lib_unsharp_masking)        }, // DRP_LIB_UNSHARPMASKING
-    {&drp_sample_Cropping,        "Cropping       ",  g_drp_lib_cropping,               sizeof(g_drp_lib_cropping)               }, // DRP_LIB_CROPPING
-    {&drp_sample_ResizeBilinearF, "ResizeBilinearF",  g_drp_lib_resize_bilinear_fixed,  sizeof(g_drp_lib_resize_bilinear_fixed)  }, // DRP_LIB_RESIZEBILINEARF
-    {&drp_sample_Histogram,       "Histogram      ",  g_drp_lib_histogram_normalization,sizeof(g_drp_lib_histogram_normalization)}, // DRP_LIB_HISTOGRAM
+//   p_func                       lib_name            lib_bin                           lib_bin_size                               src_stride  tile_group  sub_lib_no        state_bpp
+    {&drp_sample_Bayer2Grayscale, "Bayer2Grayscale",  g_drp_lib_bayer2grayscale,        sizeof(g_drp_lib_bayer2grayscale),         false, true , DRP_LIB_NONE    , 0                   }, // DRP_LIB_BAYER2GRAYSCALE
+    {&drp_sample_ImageRotate,     "ImageRotate    ",  g_drp_lib_image_rotate,           sizeof(g_drp_lib_image_rotate),            false, false, DRP_LIB_NONE    , 0                   }, // DRP_LIB_IMAGEROTATE
+    {&drp_sample_MedianBlur,      "MedianBlur     ",  g_drp_lib_median_blur,            sizeof(g_drp_lib_median_blur),             false, true , DRP_LIB_NONE    , 0                   }, // DRP_LIB_MEDIANBLUR
+    {&drp_sample_CannyCalculate,  "CannyCalculate ",  g_drp_lib_canny_calculate,        sizeof(g_drp_lib_canny_calculate),         false, false, DRP_LIB_NONE    , 0                   }, // DRP_LIB_CANNYCALCULATE
+    {&drp_sample_CannyHysterisis, "CannyHysterisis",  g_drp_lib_canny_hysterisis,       sizeof(g_drp_lib_canny_hysterisis),        false, false, DRP_LIB_NONE    , 0                   }, // DRP_LIB_CANNYHYSTERISIS
+    {&drp_sample_Binarization,    "Binarization   ",  g_drp_lib_binarization_fixed,     sizeof(g_drp_lib_binarization_fixed),      false, true , DRP_LIB_NONE    , 0                   }, // DRP_LIB_BINARIZATION
+    {&drp_sample_Erode,           "Erode          ",  g_drp_lib_erode,                  sizeof(g_drp_lib_erode),                   false, true , DRP_LIB_NONE    , 0                   }, // DRP_LIB_ERODE
+    {&drp_sample_Dilate,          "Dilate         ",  g_drp_lib_dilate,                 sizeof(g_drp_lib_dilate),                  false, true , DRP_LIB_NONE    , 0                   }, // DRP_LIB_DILATE
+    {&drp_sample_GaussianBlur,    "GaussianBlur   ",  g_drp_lib_gaussian_blur,          sizeof(g_drp_lib_gaussian_blur),           false, true , DRP_LIB_NONE    , 0                   }, // DRP_LIB_GAUSSIANBLUR
+    {&drp_sample_Sobel,           "Sobel          ",  g_drp_lib_sobel,                  sizeof(g_drp_lib_sobel),                   false, true , DRP_LIB_NONE    , 0                   }, // DRP_LIB_SOBEL
+    {&drp_sample_Prewitt,         "Prewitt        ",  g_drp_lib_prewitt,                sizeof(g_drp_lib_prewitt),                 false, true , DRP_LIB_NONE    , 0                   }, // DRP_LIB_PREWITT
+    {&drp_sample_Laplacian,       "Laplacian      ",  g_drp_lib_laplacian,              sizeof(g_drp_lib_laplacian),               false, true , DRP_LIB_NONE    , 0                   }, // DRP_LIB_LAPLACIAN
+    {&drp_sample_UnsharpMasking,  "UnsharpMasking ",  g_drp_lib_unsharp_masking,        sizeof(g_drp_lib_unsharp_masking),         false, false, DRP_LIB_NONE    , 0                   }, // DRP_LIB_UNSHARPMASKING
+    {&drp_sample_Cropping,        "Cropping       ",  g_drp_lib_cropping,               sizeof(g_drp_lib_cropping),                true , false, DRP_LIB_NONE    , 0                   }, // DRP_LIB_CROPPING
+    {&drp_sample_ResizeBilinearF, "ResizeBilinearF",  g_drp_lib_resize_bilinear_fixed,  sizeof(g_drp_lib_resize_bilinear_fixed),   true , false, DRP_LIB_CROPPING, 0                   }, // DRP_LIB_RESIZEBILINEARF
+    {&drp_sample_Histogram,       "Histogram      ",  g_drp_lib_histogram_normalization,sizeof(g_drp_lib_histogram_normalization), false, false, DRP_LIB_NONE    , 0                   }, // DRP_LIB_HISTOGRAM
+    {&cpu_sample_RunningAverage,  "RunningAverage ",  NULL,                             0,                                         true , false, DRP_LIB_NONE    , TEMPORAL_AVERAGE_BPP}, // DRP_LIB_RUNNINGAVERAGE
+    {&cpu_sample_Background,      "Background     ",  NULL,                             0,                                         true , false, DRP_LIB_NONE    , TEMPORAL_BG_BPP     }, // DRP_LIB_BACKGROUND
+    {&cpu_sample_FrameDiff,       "FrameDiff      ",  NULL,                             0,                                         true , false, DRP_LIB_NONE    , TEMPORAL_DIFF_BPP   }, // DRP_LIB_FRAMEDIFF
+    {&cpu_sample_Pyramid,         "Pyramid        ",  NULL,                             0,                                         true , false, DRP_LIB_NONE    , 0                   }, // DRP_LIB_PYRAMID
+    {&cpu_sample_AdaptiveTh,      "AdaptiveThresh ",  NULL,                             0,                                         true , false, DRP_LIB_NONE    , 0                   }, // DRP_LIB_ADAPTIVETH
+    {&cpu_sample_BoxBlur,         "BoxBlur        ",  NULL,                             0,                                         true , false, DRP_LIB_NONE    , 0                   }, // DRP_LIB_BOXBLUR
 };
 
 //
@@ -176,7 +426,7 @@ static void Start_LCD_Display(void) {
     );
     Display.Graphics_Start(DisplayBase::GRAPHICS_LAYER_0);
 
-    memset(fbuf_overlay, 0, sizeof(fbuf_overlay));
+    overlay_init(fbuf_overlay, VIDEO_PIXEL_HW, VIDEO_PIXEL_VW, FRAME_BUFFER_STRIDE);
     clut_param.color_num = sizeof(clut_data_resut) / sizeof(uint32_t);
     clut_param.clut = clut_data_resut;
 
@@ -203,9 +453,20 @@ static void Start_LCD_Display(void) {
 // Callback functions
 //
 static void IntCallbackFunc_Vfield(DisplayBase::int_type_t int_type) {
+    capture_time = exec_timer.read_us();
+    capture_seq++;
     drpTask.flags_set(DRP_FLG_CAMER_IN);
 }
 
+static void IntCallbackFunc_LoVsync(DisplayBase::int_type_t int_type) {
+    if (flip_pending) {
+        flip_time = exec_timer.read_us();
+        shown_stamp = flip_stamp;
+        flip_pending = false;
+        drpTask.flags_set(DRP_FLG_FLIP);
+    }
+}
+
 static void cb_drp_finish(uint8_t id) {
     uint32_t tile_no;
     uint32_t set_flgs = 0;
@@ -216,13 +477,232 @@ static void cb_drp_finish(uint8_t id) {
             set_flgs |= (1 << tile_no);
         }
     }
-    drpTask.flags_set(set_flgs);
+    drp_job_finish_isr(set_flgs);
+}
+
+// Unloads the circuits on the given tiles only, the other tile group may still be running
+static void unload_tiles(uint32_t tiles) {
+    for (uint32_t tile_no = 0; tile_no < R_DK2_TILE_NUM; tile_no++) {
+        uint8_t id = drp_lib_id[tile_no];
+
+        if (((tiles & (1u << tile_no)) == 0) || (id == 0)) {
+            continue;
+        }
+        R_DK2_Unload(id, drp_lib_id);
+        for (uint32_t i = 0; i < R_DK2_TILE_NUM; i++) {
+            if (drp_lib_id[i] == id) {
+                drp_lib_id[i] = 0;  // Every tile of the circuit
+            }
+        }
+    }
+}
+
+// Continuation of the last phase of every DRP stage
+static void finish_drp_job(void * p_arg) {
+    drp_lib_ctl_t * drp_lib_ctl = (drp_lib_ctl_t *)p_arg;
+
+    // A stage whose driver call failed is taken back by recover_drp_func, which releases the tiles
+    if (drp_lib_ctl->stalled) {
+        return;
+    }
+    unload_tiles(drp_lib_ctl->tiles);
+    drp_lib_ctl->run_time = exec_timer.read_us() - drp_lib_ctl->run_start - drp_job_idle_us(&drp_lib_ctl->job);
+    drp_job_unlock_tiles(drp_lib_ctl->tiles);
+}
+
+//
+// Stall detection
+// A DRP stage that runs longer than twice its recent envelope is taken as stalled (lost
+// callback, bad configuration data), and so is a stage whose driver call fails. Its tiles
+// are unloaded and released, and the stage is retried once on the same frame before the
+// frame is skipped. The envelopes of a mode are kept across its visits.
+//
+#define DRP_STALL_FIRST_US     (33000)   // One camera frame period, until the stage has finished once
+#define DRP_STALL_MARGIN_US    (2000)
+#define DRP_STALL_RETRY_MAX    (1)
+#define DRP_STALL_LOG_NUM      (8)
+
+typedef struct {
+    uint32_t      time;         // exec_timer (us)
+    uint32_t      frame_no;
+    uint32_t      drp_lib_no;
+    uint32_t      tiles;
+    uint32_t      waited;       // us since the start of the run
+    uint32_t      timeout;      // us
+    bool          skipped;      // false: retried
+} stall_event_t;
+
+static stall_event_t stall_log[DRP_STALL_LOG_NUM];
+static uint32_t stall_count = 0;
+static uint32_t stall_skipped = 0;
+static uint32_t stage_envelope[DRP_MODE_MAX + 1][DRP_LIB_MAX];  // us, longest recent run time (0: not finished yet)
+static uint32_t * cur_envelope = stage_envelope[0];              // Row of the current mode
+
+// The envelope follows a longer run at once and decays by 1/8 per run
+static void update_stage_envelope(uint32_t stage, uint32_t run_time) {
+    cur_envelope[stage] -= cur_envelope[stage] / 8;
+    if (run_time > cur_envelope[stage]) {
+        cur_envelope[stage] = run_time;
+    }
+}
+
+// A stage that has never finished gets one frame period, doubled for its retry
+static uint32_t get_stage_timeout(uint32_t stage, uint32_t retry) {
+    if (cur_envelope[stage] == 0) {
+        return DRP_STALL_FIRST_US << retry;
+    }
+    return (cur_envelope[stage] * 2) + DRP_STALL_MARGIN_US;
+}
+
+static bool is_stage_late(const drp_lib_ctl_t * drp_lib_ctl) {
+    return (exec_timer.read_us() - drp_lib_ctl->run_start) > drp_lib_ctl->timeout_us;
+}
+
+// Time left before the stage is late, for the waits of the stage and of its executor (ms, at least 1)
+static uint32_t get_stage_wait_ms(const drp_lib_ctl_t * drp_lib_ctl) {
+    uint32_t elapsed = exec_timer.read_us() - drp_lib_ctl->run_start;
+
+    if (elapsed >= drp_lib_ctl->timeout_us) {
+        return 1;
+    }
+    return ((drp_lib_ctl->timeout_us - elapsed) + 999) / 1000;
+}
+
+//
+// Stripe partition and resize ratios
+//
+typedef struct {
+    uint16_t num;
+    uint16_t den;
+    uint8_t  code;
+} resize_fixed_ratio_t;
+
+// Magnifications of the ResizeBilinearFixed library (dst size = src size * num / den), for each axis.
+// Any other ratio is resized by resize_bilinear_cpu, on the CPU in a single thread.
+static const resize_fixed_ratio_t resize_fixed_ratio_tbl[] = {
+//   num  den  code
+    {1,   4,   0x01},  // 1/4x
+    {1,   2,   0x02},  // 1/2x
+    {1,   1,   0x04},  // 1x
+    {2,   1,   0x08},  // 2x
+    {4,   1,   0x10},  // 4x
+    {8,   1,   0x20},  // 8x
+    {16,  1,   0x40},  // 16x
+};
+
+static const resize_fixed_ratio_t * get_resize_fixed_ratio(uint32_t src_size, uint32_t dst_size) {
+    for (uint32_t i = 0; i < (sizeof(resize_fixed_ratio_tbl) / sizeof(resize_fixed_ratio_t)); i++) {
+        const resize_fixed_ratio_t * p_ratio = &resize_fixed_ratio_tbl[i];
+
+        if ((dst_size * p_ratio->den) == (src_size * p_ratio->num)) {
+            return p_ratio;
+        }
+    }
+    return NULL;
+}
+
+// Splits height into stripe_num stripes whose boundaries are multiples of align
+static void get_stripe(uint32_t height, uint32_t stripe_num, uint32_t align, uint32_t idx, uint32_t * p_top, uint32_t * p_rows) {
+    uint32_t top = ((height * idx) / stripe_num / align) * align;
+    uint32_t end = (idx == (stripe_num - 1)) ? height : (((height * (idx + 1)) / stripe_num / align) * align);
+
+    *p_top  = top;
+    *p_rows = end - top;
+}
+
+// Number of stripes of a stage striped over a tile group
+static uint32_t count_tiles(uint32_t tiles) {
+    uint32_t num = 0;
+
+    for (uint32_t tile_no = 0; tile_no < R_DK2_TILE_NUM; tile_no++) {
+        if ((tiles & (1u << tile_no)) != 0) {
+            num++;
+        }
+    }
+    return num;
+}
+
+// The DRP library resizes by the ratios in resize_fixed_ratio_tbl into a packed destination only
+static bool is_resize_on_drp(const image_view_t * src, const image_view_t * dst) {
+    if ((get_resize_fixed_ratio(src->width, dst->width) == NULL) || (get_resize_fixed_ratio(src->height, dst->height) == NULL)) {
+        return false;
+    }
+    if (!image_view_is_packed(dst)) {
+        return false;
+    }
+    return true;
+}
+
+// Bytes of the work area a DRP library needs for the source (0: none). CannyCalculate takes
+// two rows of margin around each of its three stripes, ResizeBilinearF keeps two staged stripes.
+static uint32_t get_drp_work_size(uint32_t drp_lib_no, const image_view_t * src) {
+    switch (drp_lib_no) {
+        case DRP_LIB_CANNYCALCULATE:
+        case DRP_LIB_CANNYHYSTERISIS:
+            return (src->width * ((src->height / 3) + 2)) * 2 * 3;
+        case DRP_LIB_RESIZEBILINEARF:
+            return ((src->height / R_DK2_TILE_NUM) + (2 * R_DK2_TILE_NUM)) * src->width * 2;
+        default:
+            return 0;
+    }
+}
+
+// Fallback for ratios the DRP library cannot express: fixed-point bilinear on the CPU, stripe by stripe.
+// It runs on cpuTask alone, the DRP is not used.
+static void resize_bilinear_cpu(drp_lib_ctl_t * drp_lib_ctl) {
+    image_view_t * src = &drp_lib_ctl->src;
+    image_view_t * dst = &drp_lib_ctl->dst;
+    uint32_t dst_top;
+    uint32_t dst_rows;
+
+    drp_lib_ctl->load_time = 0;
+
+    cpu_timer.reset();
+    resize_bilinear_begin(src, dst);
+    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
+        get_stripe(dst->height, R_DK2_TILE_NUM, 1, idx, &dst_top, &dst_rows);
+        if (dst_rows == 0) {
+            continue;
+        }
+        resize_bilinear_stripe(dst_top, dst_top + dst_rows);
+    }
+    drp_lib_ctl->run_time = cpu_timer.read_us();
 }
 
 //
 // DRP sample functions 
 // See "mbed-gr-libs\drp-for-mbed\TARGET_RZ_A2XX\r_drp\doc" for details
 //
+// A driver call that failed stalls the stage at once, the executor takes it back.
+// The stage function still runs to its end, the starts on tiles without a circuit do nothing.
+static void check_drp_call(drp_lib_ctl_t * drp_lib_ctl, int32_t ret) {
+    if (ret != R_DK2_SUCCESS) {
+        drp_lib_ctl->stalled = true;
+    }
+}
+
+// Loads a one-tile library on every tile of the stage's tile group (the whole array in the
+// diagrams below), one stripe of rows per tile. p_tile_no gets the tile of each stripe.
+static uint32_t load_stripe_lib(drp_lib_ctl_t * drp_lib_ctl, uint32_t * p_tile_no) {
+    uint32_t stripe_num = 0;
+
+    drp_job_lock_tiles(drp_lib_ctl->tiles);
+    t.reset();
+    check_drp_call(drp_lib_ctl, drp_job_load(
+        drp_lib_ctl->p_drp_lib_bin,
+        drp_lib_ctl->tiles,
+        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id));
+    for (uint32_t tile_no = 0; tile_no < R_DK2_TILE_NUM; tile_no++) {
+        if ((drp_lib_ctl->tiles & (1u << tile_no)) != 0) {
+            check_drp_call(drp_lib_ctl, drp_job_activate(drp_lib_id[tile_no], 0));
+            p_tile_no[stripe_num++] = tile_no;
+        }
+    }
+    drp_lib_ctl->load_time = t.read_us();
+
+    return stripe_num;
+}
+
 static void drp_sample_Bayer2Grayscale(drp_lib_ctl_t * drp_lib_ctl) {
     /* Load DRP Library            */
     /*        +------------------+ */
@@ -238,28 +718,23 @@ static void drp_sample_Bayer2Grayscale(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | Bayer2Grayscale  | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
+    uint32_t tile_no[R_DK2_TILE_NUM];
+    uint32_t stripe_num = load_stripe_lib(drp_lib_ctl, tile_no);
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_bayer2grayscale_t * param_b2g = (r_drp_bayer2grayscale_t *)nc_memory;
-    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_b2g[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_b2g[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_b2g[idx].width  = VIDEO_PIXEL_HW;
-        param_b2g[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_b2g[idx].top    = (idx == 0) ? 1 : 0;
-        param_b2g[idx].bottom = (idx == 5) ? 1 : 0;
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_b2g[idx], sizeof(r_drp_bayer2grayscale_t));
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t tile = tile_no[idx];
+
+        param_b2g[tile].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / stripe_num) * idx);
+        param_b2g[tile].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / stripe_num) * idx);
+        param_b2g[tile].width  = drp_lib_ctl->src.width;
+        param_b2g[tile].height = drp_lib_ctl->src.height / stripe_num;
+        param_b2g[tile].top    = (idx == 0) ? 1 : 0;
+        param_b2g[tile].bottom = (idx == (stripe_num - 1)) ? 1 : 0;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, tile, (void *)&param_b2g[tile], sizeof(r_drp_bayer2grayscale_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_ImageRotate(drp_lib_ctl_t * drp_lib_ctl) {
@@ -277,28 +752,27 @@ static void drp_sample_ImageRotate(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | ImageRotate      | */
     /*        +------------------+ */
+    drp_job_lock();
     t.reset();
-    R_DK2_Load(
+    check_drp_call(drp_lib_ctl, drp_job_load(
         drp_lib_ctl->p_drp_lib_bin,
         R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
+        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id));
+    check_drp_call(drp_lib_ctl, drp_job_activate(0, 0));
     drp_lib_ctl->load_time = t.read_us();
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_image_rotate_t * param_rotate = (r_drp_image_rotate_t *)nc_memory;
     for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_rotate[idx].src        = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_rotate[idx].dst        = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * (R_DK2_TILE_NUM - 1 - idx));
-        param_rotate[idx].src_width  = VIDEO_PIXEL_HW;
-        param_rotate[idx].src_height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_rotate[idx].dst_stride = FRAME_BUFFER_STRIDE;
+        param_rotate[idx].src        = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / R_DK2_TILE_NUM) * idx);
+        param_rotate[idx].dst        = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->src.height / R_DK2_TILE_NUM) * (R_DK2_TILE_NUM - 1 - idx));
+        param_rotate[idx].src_width  = drp_lib_ctl->src.width;
+        param_rotate[idx].src_height = drp_lib_ctl->src.height / R_DK2_TILE_NUM;
+        param_rotate[idx].dst_stride = drp_lib_ctl->dst.stride;
         param_rotate[idx].mode       = 2; // Rotate 180 clockwise
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_rotate[idx], sizeof(r_drp_image_rotate_t));
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, idx, (void *)&param_rotate[idx], sizeof(r_drp_image_rotate_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_MedianBlur(drp_lib_ctl_t * drp_lib_ctl) {
@@ -316,28 +790,23 @@ static void drp_sample_MedianBlur(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | MedianBlur       | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
+    uint32_t tile_no[R_DK2_TILE_NUM];
+    uint32_t stripe_num = load_stripe_lib(drp_lib_ctl, tile_no);
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_median_blur_t * param_median = (r_drp_median_blur_t *)nc_memory;
-    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_median[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_median[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_median[idx].width  = VIDEO_PIXEL_HW;
-        param_median[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_median[idx].top    = (idx == 0) ? 1 : 0;
-        param_median[idx].bottom = (idx == 5) ? 1 : 0;
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_median[idx], sizeof(r_drp_median_blur_t));
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t tile = tile_no[idx];
+
+        param_median[tile].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / stripe_num) * idx);
+        param_median[tile].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / stripe_num) * idx);
+        param_median[tile].width  = drp_lib_ctl->src.width;
+        param_median[tile].height = drp_lib_ctl->src.height / stripe_num;
+        param_median[tile].top    = (idx == 0) ? 1 : 0;
+        param_median[tile].bottom = (idx == (stripe_num - 1)) ? 1 : 0;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, tile, (void *)&param_median[tile], sizeof(r_drp_median_blur_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_CannyCalculate(drp_lib_ctl_t * drp_lib_ctl) {
@@ -355,31 +824,30 @@ static void drp_sample_CannyCalculate(drp_lib_ctl_t * drp_lib_ctl) {
     /*        + CannyCalculate   + */
     /* tile 5 |                  | */
     /*        +------------------+ */
+    drp_job_lock();
     t.reset();
-    R_DK2_Load(
+    check_drp_call(drp_lib_ctl, drp_job_load(
         drp_lib_ctl->p_drp_lib_bin,
         R_DK2_TILE_0 | R_DK2_TILE_2 | R_DK2_TILE_4,
-        R_DK2_TILE_PATTERN_2_2_2, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
+        R_DK2_TILE_PATTERN_2_2_2, NULL, &cb_drp_finish, drp_lib_id));
+    check_drp_call(drp_lib_ctl, drp_job_activate(0, 0));
     drp_lib_ctl->load_time = t.read_us();
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_canny_calculate_t * param_canny_cal = (r_drp_canny_calculate_t *)nc_memory;
     for (uint32_t idx = 0; idx < 3; idx++) {
-        param_canny_cal[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / 3) * idx);
-        param_canny_cal[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / 3) * idx);
-        param_canny_cal[idx].width  = VIDEO_PIXEL_HW;
-        param_canny_cal[idx].height = (VIDEO_PIXEL_VW / 3);
+        param_canny_cal[idx].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / 3) * idx);
+        param_canny_cal[idx].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / 3) * idx);
+        param_canny_cal[idx].width  = drp_lib_ctl->src.width;
+        param_canny_cal[idx].height = (drp_lib_ctl->src.height / 3);
         param_canny_cal[idx].top    = ((idx * 2) == 0) ? 1 : 0;
         param_canny_cal[idx].bottom = ((idx * 2) == 4) ? 1 : 0;
-        param_canny_cal[idx].work   = (uint32_t)&drp_work_buf[((VIDEO_PIXEL_HW * ((VIDEO_PIXEL_VW / 3) + 2)) * 2) * idx];
-        param_canny_cal[idx].threshold_high = 0x28;
-        param_canny_cal[idx].threshold_low  = 0x18;
-        R_DK2_Start(drp_lib_id[(idx * 2)], (void *)&param_canny_cal[idx], sizeof(r_drp_canny_calculate_t));
+        param_canny_cal[idx].work   = (uint32_t)drp_lib_ctl->work.base + (((drp_lib_ctl->src.width * ((drp_lib_ctl->src.height / 3) + 2)) * 2) * idx);
+        param_canny_cal[idx].threshold_high = drp_lib_ctl->p_param->value[PARAM_CANNY_TH_HIGH];
+        param_canny_cal[idx].threshold_low  = drp_lib_ctl->p_param->value[PARAM_CANNY_TH_LOW];
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, (idx * 2), (void *)&param_canny_cal[idx], sizeof(r_drp_canny_calculate_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_CannyHysterisis(drp_lib_ctl_t * drp_lib_ctl) {
@@ -397,26 +865,25 @@ static void drp_sample_CannyHysterisis(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +                  + */
     /* tile 5 |                  | */
     /*        +------------------+ */
+    drp_job_lock();
     t.reset();
-    R_DK2_Load(
+    check_drp_call(drp_lib_ctl, drp_job_load(
         drp_lib_ctl->p_drp_lib_bin,
         R_DK2_TILE_0,
-        R_DK2_TILE_PATTERN_6, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
+        R_DK2_TILE_PATTERN_6, NULL, &cb_drp_finish, drp_lib_id));
+    check_drp_call(drp_lib_ctl, drp_job_activate(0, 0));
     drp_lib_ctl->load_time = t.read_us();
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_canny_hysterisis_t * param_canny_hyst = (r_drp_canny_hysterisis_t *)nc_memory;
-    param_canny_hyst[0].src    = (uint32_t)drp_lib_ctl->src;
-    param_canny_hyst[0].dst    = (uint32_t)drp_lib_ctl->dst;
-    param_canny_hyst[0].width  = VIDEO_PIXEL_HW;
-    param_canny_hyst[0].height = VIDEO_PIXEL_VW;
-    param_canny_hyst[0].work   = (uint32_t)drp_work_buf;
+    param_canny_hyst[0].src    = (uint32_t)drp_lib_ctl->src.base;
+    param_canny_hyst[0].dst    = (uint32_t)drp_lib_ctl->dst.base;
+    param_canny_hyst[0].width  = drp_lib_ctl->src.width;
+    param_canny_hyst[0].height = drp_lib_ctl->src.height;
+    param_canny_hyst[0].work   = (uint32_t)drp_lib_ctl->work.base;
     param_canny_hyst[0].iterations = 2;
-    R_DK2_Start(drp_lib_id[0], (void *)&param_canny_hyst[0], sizeof(r_drp_canny_hysterisis_t));
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, 0, (void *)&param_canny_hyst[0], sizeof(r_drp_canny_hysterisis_t)));
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_Binarization(drp_lib_ctl_t * drp_lib_ctl) {
@@ -434,27 +901,22 @@ static void drp_sample_Binarization(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | Binarization     | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
+    uint32_t tile_no[R_DK2_TILE_NUM];
+    uint32_t stripe_num = load_stripe_lib(drp_lib_ctl, tile_no);
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_binarization_fixed_t * param_binfix = (r_drp_binarization_fixed_t *)nc_memory;
-    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_binfix[idx].src       = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_binfix[idx].dst       = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_binfix[idx].width     = VIDEO_PIXEL_HW;
-        param_binfix[idx].height    = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_binfix[idx].threshold = 100;
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_binfix[idx], sizeof(r_drp_binarization_fixed_t));
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t tile = tile_no[idx];
+
+        param_binfix[tile].src       = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / stripe_num) * idx);
+        param_binfix[tile].dst       = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / stripe_num) * idx);
+        param_binfix[tile].width     = drp_lib_ctl->src.width;
+        param_binfix[tile].height    = drp_lib_ctl->src.height / stripe_num;
+        param_binfix[tile].threshold = drp_lib_ctl->p_param->value[PARAM_BINARIZATION_TH];
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, tile, (void *)&param_binfix[tile], sizeof(r_drp_binarization_fixed_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_Erode(drp_lib_ctl_t * drp_lib_ctl) {
@@ -472,28 +934,23 @@ static void drp_sample_Erode(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | Erode            | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
+    uint32_t tile_no[R_DK2_TILE_NUM];
+    uint32_t stripe_num = load_stripe_lib(drp_lib_ctl, tile_no);
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_erode_t * param_erode = (r_drp_erode_t *)nc_memory;
-    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_erode[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_erode[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_erode[idx].width  = VIDEO_PIXEL_HW;
-        param_erode[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_erode[idx].top    = (idx == 0) ? 1 : 0;
-        param_erode[idx].bottom = (idx == 5) ? 1 : 0;
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_erode[idx], sizeof(r_drp_erode_t));
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t tile = tile_no[idx];
+
+        param_erode[tile].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / stripe_num) * idx);
+        param_erode[tile].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / stripe_num) * idx);
+        param_erode[tile].width  = drp_lib_ctl->src.width;
+        param_erode[tile].height = drp_lib_ctl->src.height / stripe_num;
+        param_erode[tile].top    = (idx == 0) ? 1 : 0;
+        param_erode[tile].bottom = (idx == (stripe_num - 1)) ? 1 : 0;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, tile, (void *)&param_erode[tile], sizeof(r_drp_erode_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_Dilate(drp_lib_ctl_t * drp_lib_ctl) {
@@ -511,28 +968,23 @@ static void drp_sample_Dilate(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | Dilate           | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
+    uint32_t tile_no[R_DK2_TILE_NUM];
+    uint32_t stripe_num = load_stripe_lib(drp_lib_ctl, tile_no);
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_dilate_t * param_dilate = (r_drp_dilate_t *)nc_memory;
-    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_dilate[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_dilate[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_dilate[idx].width  = VIDEO_PIXEL_HW;
-        param_dilate[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_dilate[idx].top    = (idx == 0) ? 1 : 0;
-        param_dilate[idx].bottom = (idx == 5) ? 1 : 0;
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_dilate[idx], sizeof(r_drp_dilate_t));
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t tile = tile_no[idx];
+
+        param_dilate[tile].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / stripe_num) * idx);
+        param_dilate[tile].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / stripe_num) * idx);
+        param_dilate[tile].width  = drp_lib_ctl->src.width;
+        param_dilate[tile].height = drp_lib_ctl->src.height / stripe_num;
+        param_dilate[tile].top    = (idx == 0) ? 1 : 0;
+        param_dilate[tile].bottom = (idx == (stripe_num - 1)) ? 1 : 0;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, tile, (void *)&param_dilate[tile], sizeof(r_drp_dilate_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_GaussianBlur(drp_lib_ctl_t * drp_lib_ctl) {
@@ -550,28 +1002,23 @@ static void drp_sample_GaussianBlur(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | Gaussian Blur    | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
+    uint32_t tile_no[R_DK2_TILE_NUM];
+    uint32_t stripe_num = load_stripe_lib(drp_lib_ctl, tile_no);
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_gaussian_blur_t * param_gauss = (r_drp_gaussian_blur_t *)nc_memory;
-    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_gauss[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_gauss[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_gauss[idx].width  = VIDEO_PIXEL_HW;
-        param_gauss[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_gauss[idx].top    = (idx == 0) ? 1 : 0;
-        param_gauss[idx].bottom = (idx == 5) ? 1 : 0;
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_gauss[idx], sizeof(r_drp_gaussian_blur_t));
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t tile = tile_no[idx];
+
+        param_gauss[tile].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / stripe_num) * idx);
+        param_gauss[tile].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / stripe_num) * idx);
+        param_gauss[tile].width  = drp_lib_ctl->src.width;
+        param_gauss[tile].height = drp_lib_ctl->src.height / stripe_num;
+        param_gauss[tile].top    = (idx == 0) ? 1 : 0;
+        param_gauss[tile].bottom = (idx == (stripe_num - 1)) ? 1 : 0;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, tile, (void *)&param_gauss[tile], sizeof(r_drp_gaussian_blur_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_Sobel(drp_lib_ctl_t * drp_lib_ctl) {
@@ -589,28 +1036,26 @@ static void drp_sample_Sobel(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | Sobel            | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
+    uint32_t tile_no[R_DK2_TILE_NUM];
+    uint32_t stripe_num = load_stripe_lib(drp_lib_ctl, tile_no);
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_sobel_t * param_sobel = (r_drp_sobel_t *)nc_memory;
-    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_sobel[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_sobel[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_sobel[idx].width  = VIDEO_PIXEL_HW;
-        param_sobel[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_sobel[idx].top    = (idx == 0) ? 1 : 0;
-        param_sobel[idx].bottom = (idx == 5) ? 1 : 0;
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_sobel[idx], sizeof(r_drp_sobel_t));
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t tile = tile_no[idx];
+
+        if ((drp_lib_ctl->stripe_mask & (1u << idx)) == 0) {
+            continue;  // Nothing to find in this stripe, it was cleared by select_stripes
+        }
+        param_sobel[tile].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / stripe_num) * idx);
+        param_sobel[tile].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / stripe_num) * idx);
+        param_sobel[tile].width  = drp_lib_ctl->src.width;
+        param_sobel[tile].height = drp_lib_ctl->src.height / stripe_num;
+        param_sobel[tile].top    = (idx == 0) ? 1 : 0;
+        param_sobel[tile].bottom = (idx == (stripe_num - 1)) ? 1 : 0;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, tile, (void *)&param_sobel[tile], sizeof(r_drp_sobel_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_Prewitt(drp_lib_ctl_t * drp_lib_ctl) {
@@ -628,28 +1073,26 @@ static void drp_sample_Prewitt(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | Prewitt          | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
+    uint32_t tile_no[R_DK2_TILE_NUM];
+    uint32_t stripe_num = load_stripe_lib(drp_lib_ctl, tile_no);
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_prewitt_t * param_prewitt = (r_drp_prewitt_t *)nc_memory;
-    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_prewitt[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_prewitt[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_prewitt[idx].width  = VIDEO_PIXEL_HW;
-        param_prewitt[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_prewitt[idx].top    = (idx == 0) ? 1 : 0;
-        param_prewitt[idx].bottom = (idx == 5) ? 1 : 0;
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_prewitt[idx], sizeof(r_drp_prewitt_t));
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t tile = tile_no[idx];
+
+        if ((drp_lib_ctl->stripe_mask & (1u << idx)) == 0) {
+            continue;  // Nothing to find in this stripe, it was cleared by select_stripes
+        }
+        param_prewitt[tile].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / stripe_num) * idx);
+        param_prewitt[tile].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / stripe_num) * idx);
+        param_prewitt[tile].width  = drp_lib_ctl->src.width;
+        param_prewitt[tile].height = drp_lib_ctl->src.height / stripe_num;
+        param_prewitt[tile].top    = (idx == 0) ? 1 : 0;
+        param_prewitt[tile].bottom = (idx == (stripe_num - 1)) ? 1 : 0;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, tile, (void *)&param_prewitt[tile], sizeof(r_drp_prewitt_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_Laplacian(drp_lib_ctl_t * drp_lib_ctl) {
@@ -667,28 +1110,26 @@ static void drp_sample_Laplacian(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | Laplacian        | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
+    uint32_t tile_no[R_DK2_TILE_NUM];
+    uint32_t stripe_num = load_stripe_lib(drp_lib_ctl, tile_no);
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_laplacian_t * param_laplacian = (r_drp_laplacian_t *)nc_memory;
-    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_laplacian[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_laplacian[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_laplacian[idx].width  = VIDEO_PIXEL_HW;
-        param_laplacian[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
-        param_laplacian[idx].top    = (idx == 0) ? 1 : 0;
-        param_laplacian[idx].bottom = (idx == 5) ? 1 : 0;
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_laplacian[idx], sizeof(r_drp_laplacian_t));
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t tile = tile_no[idx];
+
+        if ((drp_lib_ctl->stripe_mask & (1u << idx)) == 0) {
+            continue;  // Nothing to find in this stripe, it was cleared by select_stripes
+        }
+        param_laplacian[tile].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / stripe_num) * idx);
+        param_laplacian[tile].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / stripe_num) * idx);
+        param_laplacian[tile].width  = drp_lib_ctl->src.width;
+        param_laplacian[tile].height = drp_lib_ctl->src.height / stripe_num;
+        param_laplacian[tile].top    = (idx == 0) ? 1 : 0;
+        param_laplacian[tile].bottom = (idx == (stripe_num - 1)) ? 1 : 0;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, tile, (void *)&param_laplacian[tile], sizeof(r_drp_laplacian_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_UnsharpMasking(drp_lib_ctl_t * drp_lib_ctl) {
@@ -706,29 +1147,28 @@ static void drp_sample_UnsharpMasking(drp_lib_ctl_t * drp_lib_ctl) {
     /*        + UnsharpMasking   + */
     /* tile 5 |                  | */
     /*        +------------------+ */
+    drp_job_lock();
     t.reset();
-    R_DK2_Load(
+    check_drp_call(drp_lib_ctl, drp_job_load(
         drp_lib_ctl->p_drp_lib_bin,
         R_DK2_TILE_0 | R_DK2_TILE_2 | R_DK2_TILE_4,
-        R_DK2_TILE_PATTERN_2_2_2, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
+        R_DK2_TILE_PATTERN_2_2_2, NULL, &cb_drp_finish, drp_lib_id));
+    check_drp_call(drp_lib_ctl, drp_job_activate(0, 0));
     drp_lib_ctl->load_time = t.read_us();
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_unsharp_masking_t * param_unsharp = (r_drp_unsharp_masking_t *)nc_memory;
     for (uint32_t idx = 0; idx < 3; idx++) {
-        param_unsharp[idx].src      = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / 3) * idx);
-        param_unsharp[idx].dst      = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / 3) * idx);
-        param_unsharp[idx].width    = VIDEO_PIXEL_HW;
-        param_unsharp[idx].height   = (VIDEO_PIXEL_VW / 3);
-        param_unsharp[idx].strength = 255;
+        param_unsharp[idx].src      = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / 3) * idx);
+        param_unsharp[idx].dst      = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / 3) * idx);
+        param_unsharp[idx].width    = drp_lib_ctl->src.width;
+        param_unsharp[idx].height   = (drp_lib_ctl->src.height / 3);
+        param_unsharp[idx].strength = drp_lib_ctl->p_param->value[PARAM_UNSHARP_STRENGTH];
         param_unsharp[idx].top      = ((idx * 2) == 0) ? 1 : 0;
         param_unsharp[idx].bottom   = ((idx * 2) == 4) ? 1 : 0;
-        R_DK2_Start(drp_lib_id[(idx * 2)], (void *)&param_unsharp[idx], sizeof(r_drp_unsharp_masking_t));
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, (idx * 2), (void *)&param_unsharp[idx], sizeof(r_drp_unsharp_masking_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_Cropping(drp_lib_ctl_t * drp_lib_ctl) {
@@ -736,75 +1176,47 @@ static void drp_sample_Cropping(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 0 | Cropping         | */
     /*        +------------------+ */
-    /* tile 1 |                  | */
-    /*        +                  + */
-    /* tile 2 |                  | */
-    /*        +                  + */
-    /* tile 3 | Not used         | */
-    /*        +                  + */
-    /* tile 4 |                  | */
-    /*        +                  + */
-    /* tile 5 |                  | */
+    /* tile 1 | Cropping         | */
     /*        +------------------+ */
-    t.reset();
-    R_DK2_Load(
-        drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
-    drp_lib_ctl->load_time = t.read_us();
-
-    t.reset();
-    r_drp_cropping_t * param_cropping = (r_drp_cropping_t *)nc_memory;
-    param_cropping[0].src        = (uint32_t)drp_lib_ctl->src;
-    param_cropping[0].dst        = (uint32_t)drp_lib_ctl->dst;
-    param_cropping[0].src_width  = VIDEO_PIXEL_HW;
-    param_cropping[0].src_height = VIDEO_PIXEL_VW;
-    param_cropping[0].offset_x   = VIDEO_PIXEL_HW / 4;
-    param_cropping[0].offset_y   = VIDEO_PIXEL_VW / 4;
-    param_cropping[0].dst_width  = VIDEO_PIXEL_HW / 2;
-    param_cropping[0].dst_height = VIDEO_PIXEL_VW / 2;
-    R_DK2_Start(drp_lib_id[0], (void *)&param_cropping[0], sizeof(r_drp_cropping_t));
-    ThisThread::flags_wait_all(R_DK2_TILE_0);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
-}
-
-static void drp_sample_ResizeBilinearF(drp_lib_ctl_t * drp_lib_ctl) {
-    /* Load DRP Library            */
+    /* tile 2 | Cropping         | */
     /*        +------------------+ */
-    /* tile 0 |                  | */
-    /*        +                  + */
-    /* tile 1 |                  | */
-    /*        + ResizeBilinearF  + */
-    /* tile 2 |                  | */
-    /*        +                  + */
-    /* tile 3 |                  | */
+    /* tile 3 | Cropping         | */
     /*        +------------------+ */
-    /* tile 4 |                  | */
-    /*        + Not used         + */
-    /* tile 5 |                  | */
+    /* tile 4 | Cropping         | */
+    /*        +------------------+ */
+    /* tile 5 | Cropping         | */
     /*        +------------------+ */
+    drp_job_lock();
     t.reset();
-    R_DK2_Load(
+    check_drp_call(drp_lib_ctl, drp_job_load(
         drp_lib_ctl->p_drp_lib_bin,
-        R_DK2_TILE_0,
-        R_DK2_TILE_PATTERN_4_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
+        R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
+        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id));
+    check_drp_call(drp_lib_ctl, drp_job_activate(0, 0));
     drp_lib_ctl->load_time = t.read_us();
 
-    t.reset();
-    r_drp_resize_bilinear_fixed_t * param_resize = (r_drp_resize_bilinear_fixed_t *)nc_memory;
-    param_resize[0].src        = (uint32_t)drp_lib_ctl->src;
-    param_resize[0].dst        = (uint32_t)drp_lib_ctl->dst;
-    param_resize[0].src_width  = VIDEO_PIXEL_HW / 2;
-    param_resize[0].src_height = VIDEO_PIXEL_VW / 2;
-    param_resize[0].fx         = 0x08;  // 2x
-    param_resize[0].fy         = 0x08;  // 2x
-    R_DK2_Start(drp_lib_id[0], (void *)&param_resize[0], sizeof(r_drp_resize_bilinear_fixed_t));
-    ThisThread::flags_wait_all(R_DK2_TILE_0);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_lib_ctl->run_start = exec_timer.read_us();
+    r_drp_cropping_t * param_cropping = (r_drp_cropping_t *)nc_memory;
+    uint32_t top;
+    uint32_t rows;
+
+    // Copy the (strided) source view into the packed destination, one stripe of rows per tile
+    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
+        get_stripe(drp_lib_ctl->src.height, R_DK2_TILE_NUM, 1, idx, &top, &rows);
+        if (rows == 0) {
+            continue;
+        }
+        param_cropping[idx].src        = (uint32_t)image_view_row(&drp_lib_ctl->src, top);
+        param_cropping[idx].dst        = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->src.width * top);
+        param_cropping[idx].src_width  = drp_lib_ctl->src.stride;
+        param_cropping[idx].src_height = rows;
+        param_cropping[idx].offset_x   = 0;
+        param_cropping[idx].offset_y   = 0;
+        param_cropping[idx].dst_width  = drp_lib_ctl->src.width;
+        param_cropping[idx].dst_height = rows;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, idx, (void *)&param_cropping[idx], sizeof(r_drp_cropping_t)));
+    }
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
 static void drp_sample_Histogram(drp_lib_ctl_t * drp_lib_ctl) {
@@ -822,33 +1234,37 @@ static void drp_sample_Histogram(drp_lib_ctl_t * drp_lib_ctl) {
     /*        +------------------+ */
     /* tile 5 | Histogram        | */
     /*        +------------------+ */
+    drp_job_lock();
     t.reset();
-    R_DK2_Load(
+    check_drp_call(drp_lib_ctl, drp_job_load(
         drp_lib_ctl->p_drp_lib_bin,
         R_DK2_TILE_0 | R_DK2_TILE_1 | R_DK2_TILE_2 | R_DK2_TILE_3 | R_DK2_TILE_4 | R_DK2_TILE_5,
-        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id);
-    R_DK2_Activate(0, 0);
+        R_DK2_TILE_PATTERN_1_1_1_1_1_1, NULL, &cb_drp_finish, drp_lib_id));
+    check_drp_call(drp_lib_ctl, drp_job_activate(0, 0));
     drp_lib_ctl->load_time = t.read_us();
 
-    t.reset();
+    drp_lib_ctl->run_start = exec_timer.read_us();
     r_drp_histogram_normalization_t * param_histo = (r_drp_histogram_normalization_t *)nc_memory;
     r_drp_histogram_normalization_output_mode1_t * param_histogram_normalization1;
     param_histogram_normalization1 = (r_drp_histogram_normalization_output_mode1_t *)((uint32_t)nc_memory + sizeof(r_drp_histogram_normalization_t));
 
     // MODE1: Survey the overall brightness of the image
     for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_histo[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
+        param_histo[idx].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / R_DK2_TILE_NUM) * idx);
         param_histo[idx].dst    = (uint32_t)&param_histogram_normalization1[idx];
-        param_histo[idx].width  = VIDEO_PIXEL_HW;
-        param_histo[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
+        param_histo[idx].width  = drp_lib_ctl->src.width;
+        param_histo[idx].height = drp_lib_ctl->src.height / R_DK2_TILE_NUM;
         param_histo[idx].src_pixel_mean = 0;
         param_histo[idx].src_pixel_rstd = 0;
         param_histo[idx].dst_pixel_mean = 0;
         param_histo[idx].dst_pixel_std  = 0;
         param_histo[idx].mode           = 1;  // MODE1
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_histo[idx], sizeof(r_drp_histogram_normalization_t));
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, idx, (void *)&param_histo[idx], sizeof(r_drp_histogram_normalization_t)));
+    }
+    if (drp_lib_ctl->stalled || !drp_job_wait(&drp_lib_ctl->job, get_stage_wait_ms(drp_lib_ctl))) {
+        drp_lib_ctl->stalled = true;  // Taken back by the executor
+        return;
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
 
     volatile double sum = 0;
     volatile double square_sum = 0;
@@ -858,159 +1274,953 @@ static void drp_sample_Histogram(drp_lib_ctl_t * drp_lib_ctl) {
         square_sum += param_histogram_normalization1[idx].square_sum;
     }
 
-    volatile double mean = sum / (VIDEO_PIXEL_HW * VIDEO_PIXEL_VW);
-    volatile double std = sqrt(square_sum / (VIDEO_PIXEL_HW * VIDEO_PIXEL_VW) - (mean * mean));
+    volatile double mean = sum / (drp_lib_ctl->src.width * drp_lib_ctl->src.height);
+    volatile double std = sqrt(square_sum / (drp_lib_ctl->src.width * drp_lib_ctl->src.height) - (mean * mean));
     volatile uint32_t src_pixel_mean = mean * 4096;
     volatile uint32_t src_pixel_rstd = 4096 / std;
 
     // MODE2: Normalize the image
     for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
-        param_histo[idx].src    = (uint32_t)drp_lib_ctl->src + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_histo[idx].dst    = (uint32_t)drp_lib_ctl->dst + (VIDEO_PIXEL_HW * (VIDEO_PIXEL_VW / R_DK2_TILE_NUM) * idx);
-        param_histo[idx].width  = VIDEO_PIXEL_HW;
-        param_histo[idx].height = VIDEO_PIXEL_VW / R_DK2_TILE_NUM;
+        param_histo[idx].src    = (uint32_t)drp_lib_ctl->src.base + (drp_lib_ctl->src.stride * (drp_lib_ctl->src.height / R_DK2_TILE_NUM) * idx);
+        param_histo[idx].dst    = (uint32_t)drp_lib_ctl->dst.base + (drp_lib_ctl->dst.stride * (drp_lib_ctl->dst.height / R_DK2_TILE_NUM) * idx);
+        param_histo[idx].width  = drp_lib_ctl->src.width;
+        param_histo[idx].height = drp_lib_ctl->src.height / R_DK2_TILE_NUM;
         param_histo[idx].src_pixel_mean = src_pixel_mean;
         param_histo[idx].src_pixel_rstd = src_pixel_rstd;
-        param_histo[idx].dst_pixel_mean = 112;
-        param_histo[idx].dst_pixel_std  = 48;
+        param_histo[idx].dst_pixel_mean = drp_lib_ctl->p_param->value[PARAM_HISTOGRAM_MEAN];
+        param_histo[idx].dst_pixel_std  = drp_lib_ctl->p_param->value[PARAM_HISTOGRAM_STD];
         param_histo[idx].mode           = 2;  // MODE2
-        R_DK2_Start(drp_lib_id[idx], (void *)&param_histo[idx], sizeof(r_drp_histogram_normalization_t));
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, idx, (void *)&param_histo[idx], sizeof(r_drp_histogram_normalization_t)));
     }
-    ThisThread::flags_wait_all(DRP_FLG_TILE_ALL);
-    R_DK2_Unload(0, drp_lib_id);
-    drp_lib_ctl->run_time = t.read_us();
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
-//
-// Register DRP function
-//
-static void init_drp_work_memory(void) {
-#if RAM_TABLE_DYNAMIC_LOADING
-    drp_work_memory_top = drp_lib_work_memory;
-#endif
-}
+static void drp_sample_ResizeBilinearF(drp_lib_ctl_t * drp_lib_ctl) {
+    /* Load DRP Library            */
+    /*        +------------------+ */
+    /* tile 0 |                  | */
+    /*        +                  + */
+    /* tile 1 |                  | */
+    /*        + ResizeBilinearF  + */
+    /* tile 2 |                  | */
+    /*        +                  + */
+    /* tile 3 |                  | */
+    /*        +------------------+ */
+    /* tile 4 | Cropping         | */
+    /*        +------------------+ */
+    /* tile 5 | Cropping         | */
+    /*        +------------------+ */
+    /* ResizeBilinearFixed is one four-tile circuit, the output is made in six stripes.   */
+    /* Tiles 4 and 5 copy the source view (strided or not) stripe by stripe into          */
+    /* the work area while tiles 0-3 resize the previous stripe, so a crop view is resized */
+    /* without a Cropping stage of its own. Every stripe but the last one carries the     */
+    /* source rows of the next output row so that the interpolation across the seam is   */
+    /* exact; the rows it produces below the stripe are overwritten by the next stripe.   */
+    image_view_t * src = &drp_lib_ctl->src;
+    image_view_t * dst = &drp_lib_ctl->dst;
+    const resize_fixed_ratio_t * p_fx = get_resize_fixed_ratio(src->width, dst->width);
+    const resize_fixed_ratio_t * p_fy = get_resize_fixed_ratio(src->height, dst->height);
+    uint32_t slot_size = ((src->height / R_DK2_TILE_NUM) + (2 * R_DK2_TILE_NUM)) * src->width;
+    uint8_t crop_lib_id[R_DK2_TILE_NUM] = {0};
+    drp_job_t crop_job[2] = {};
+
+    drp_job_lock();
+    t.reset();
+    check_drp_call(drp_lib_ctl, drp_job_load(
+        drp_lib_ctl->p_drp_lib_bin,
+        R_DK2_TILE_0,
+        R_DK2_TILE_PATTERN_4_1_1, NULL, &cb_drp_finish, drp_lib_id));
+    check_drp_call(drp_lib_ctl, drp_job_load(
+        drp_lib_ctl->p_drp_sub_bin,
+        R_DK2_TILE_4 | R_DK2_TILE_5,
+        R_DK2_TILE_PATTERN_4_1_1, NULL, &cb_drp_finish, crop_lib_id));
+    drp_lib_id[4] = crop_lib_id[4];
+    drp_lib_id[5] = crop_lib_id[5];
+    check_drp_call(drp_lib_ctl, drp_job_activate(0, 0));
+    drp_lib_ctl->load_time = t.read_us();
 
-static uint8_t * get_configuration_data(const uint8_t * lib_bin, uint32_t lib_bin_size) {
-#if RAM_TABLE_DYNAMIC_LOADING
-    uint8_t * ret_addr = drp_work_memory_top;
+    drp_lib_ctl->run_start = exec_timer.read_us();
+    r_drp_resize_bilinear_fixed_t * param_resize = (r_drp_resize_bilinear_fixed_t *)nc_memory;
+    r_drp_cropping_t * param_cropping = (r_drp_cropping_t *)&param_resize[1];
+    uint32_t top[R_DK2_TILE_NUM];
+    uint32_t rows[R_DK2_TILE_NUM];
 
-    drp_work_memory_top = (uint8_t *)(((uint32_t)drp_work_memory_top + lib_bin_size + 32ul) & ~31ul);
-    if ((uint32_t)drp_work_memory_top > ((uint32_t)drp_lib_work_memory + sizeof(drp_lib_work_memory))) {
-        printf("drp_lib_work_memory size error\r\n");
-        while (1);
+    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
+        get_stripe(src->height, R_DK2_TILE_NUM, p_fy->den, idx, &top[idx], &rows[idx]);
+        if (idx < (R_DK2_TILE_NUM - 1)) {
+            rows[idx] += p_fy->den;  // Overlap with the next stripe
+        }
     }
-    memcpy(ret_addr, lib_bin,  lib_bin_size);
-    dcache_clean(ret_addr, lib_bin_size);
 
-    return ret_addr;
-#else
-    (void)lib_bin_size;
+    // Crop the first two stripes
+    for (uint32_t idx = 0; idx < 2; idx++) {
+        param_cropping[idx].src        = (uint32_t)image_view_row(src, top[idx]);
+        param_cropping[idx].dst        = (uint32_t)&drp_lib_ctl->work.base[slot_size * idx];
+        param_cropping[idx].src_width  = src->stride;
+        param_cropping[idx].src_height = rows[idx];
+        param_cropping[idx].offset_x   = 0;
+        param_cropping[idx].offset_y   = 0;
+        param_cropping[idx].dst_width  = src->width;
+        param_cropping[idx].dst_height = rows[idx];
+        check_drp_call(drp_lib_ctl, drp_job_start(&crop_job[idx], drp_lib_id, 4 + idx, (void *)&param_cropping[idx], sizeof(r_drp_cropping_t)));
+    }
 
-    return (uint8_t *)lib_bin;
-#endif
-}
+    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
+        uint32_t slot = idx & 1;
 
-static void set_drp_func(drp_lib_ctl_t * p_drp_lib, uint32_t drp_lib_no, uint8_t * src, uint8_t * dst) {
-    const drp_lib_func * p_drp_lib_func = &drp_lib_func_tbl[drp_lib_no];
+        // Resize the stripe as soon as it has been cropped
+        if (!drp_job_wait(&crop_job[slot], get_stage_wait_ms(drp_lib_ctl))) {
+            drp_lib_ctl->stalled = true;
+            break;
+        }
+        param_resize[0].src        = (uint32_t)&drp_lib_ctl->work.base[slot_size * slot];
+        param_resize[0].dst        = (uint32_t)image_view_row(dst, (top[idx] * p_fy->num) / p_fy->den);
+        param_resize[0].src_width  = src->width;
+        param_resize[0].src_height = rows[idx];
+        param_resize[0].fx         = p_fx->code;
+        param_resize[0].fy         = p_fy->code;
+        check_drp_call(drp_lib_ctl, drp_job_start(&drp_lib_ctl->job, drp_lib_id, 0, (void *)&param_resize[0], sizeof(r_drp_resize_bilinear_fixed_t)));
+        if (((idx + 1) < R_DK2_TILE_NUM) && !drp_job_wait(&drp_lib_ctl->job, get_stage_wait_ms(drp_lib_ctl))) {
+            drp_lib_ctl->stalled = true;
+            break;
+        }
 
-    p_drp_lib->drp_lib_no = drp_lib_no;
-    p_drp_lib->p_drp_lib_bin = get_configuration_data(p_drp_lib_func->lib_bin, p_drp_lib_func->lib_bin_size);
-    p_drp_lib->src = src;
-    p_drp_lib->dst = dst;
+        // The slot is free again, crop the stripe after next into it
+        if ((idx + 2) < R_DK2_TILE_NUM) {
+            param_cropping[slot].src        = (uint32_t)image_view_row(src, top[idx + 2]);
+            param_cropping[slot].src_height = rows[idx + 2];
+            param_cropping[slot].dst_height = rows[idx + 2];
+            check_drp_call(drp_lib_ctl, drp_job_start(&crop_job[slot], drp_lib_id, 4 + slot, (void *)&param_cropping[slot], sizeof(r_drp_cropping_t)));
+        }
+    }
+
+    // Taken back by the executor. The crop jobs live on this stack, none may stay running.
+    if (drp_lib_ctl->stalled) {
+        drp_job_abort(&crop_job[0]);
+        drp_job_abort(&crop_job[1]);
+        return;
+    }
+    drp_job_then(&drp_lib_ctl->job, &finish_drp_job, drp_lib_ctl);
 }
 
-static uint32_t init_drp_lib(uint32_t mode) {
-    uint32_t idx = 0;
+//
+// Temporal sample functions (CPU)
+// The state is updated in place stripe by stripe, on the same partition as the DRP libraries.
+//
+typedef void (*temporal_func_t)(temporal_state_t * p_state, const image_view_t * p_src, const image_view_t * p_dst,
+                                uint32_t top, uint32_t rows);
 
-    init_drp_work_memory();
-    memset(fbuf_overlay, 0, sizeof(fbuf_overlay));
+static void run_temporal_func(drp_lib_ctl_t * drp_lib_ctl, temporal_func_t p_func) {
+    image_view_t * src = &drp_lib_ctl->src;
+    image_view_t * dst = &drp_lib_ctl->dst;
+    uint32_t top;
+    uint32_t rows;
+
+    drp_lib_ctl->load_time = 0;
+
+    cpu_timer.reset();
+    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
+        get_stripe(src->height, R_DK2_TILE_NUM, 1, idx, &top, &rows);
+        if (rows == 0) {
+            continue;
+        }
+        p_func(drp_lib_ctl->p_temporal, src, dst, top, rows);
+    }
+    temporal_frame_end(drp_lib_ctl->p_temporal);
+    drp_lib_ctl->run_time = cpu_timer.read_us();
+}
+
+static void cpu_sample_RunningAverage(drp_lib_ctl_t * drp_lib_ctl) {
+    run_temporal_func(drp_lib_ctl, &temporal_running_average);
+}
+
+static void cpu_sample_Background(drp_lib_ctl_t * drp_lib_ctl) {
+    run_temporal_func(drp_lib_ctl, &temporal_background);
+}
+
+static void cpu_sample_FrameDiff(drp_lib_ctl_t * drp_lib_ctl) {
+    run_temporal_func(drp_lib_ctl, &temporal_frame_diff);
+}
+
+// The dst view is pyramid_view() of the pyramid buffer
+static void cpu_sample_Pyramid(drp_lib_ctl_t * drp_lib_ctl) {
+    drp_lib_ctl->load_time = 0;
+    cpu_timer.reset();
+    pyramid_build(&drp_lib_ctl->src, drp_lib_ctl->dst.base);
+    drp_lib_ctl->run_time = cpu_timer.read_us();
+}
+
+//
+// Integral image sample functions (CPU)
+// Each stripe rolls the two rows of the summed-area table that bound its window down the image,
+// so the box filters read four entries per pixel whatever the window size without keeping the table.
+//
+static void cpu_sample_AdaptiveTh(drp_lib_ctl_t * drp_lib_ctl) {
+    uint32_t radius = drp_lib_ctl->p_param->value[PARAM_ADAPTIVE_RADIUS];
+    int32_t offset  = drp_lib_ctl->p_param->value[PARAM_ADAPTIVE_OFFSET];
+    uint32_t top;
+    uint32_t rows;
+
+    drp_lib_ctl->load_time = 0;
+    cpu_timer.reset();
+    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
+        get_stripe(drp_lib_ctl->dst.height, R_DK2_TILE_NUM, 1, idx, &top, &rows);
+        if (rows != 0) {
+            integral_adaptive_threshold(&drp_lib_ctl->src, &drp_lib_ctl->dst, radius, offset, top, rows);
+        }
+    }
+    drp_lib_ctl->run_time = cpu_timer.read_us();
+}
+
+static void cpu_sample_BoxBlur(drp_lib_ctl_t * drp_lib_ctl) {
+    uint32_t radius = drp_lib_ctl->p_param->value[PARAM_BOX_RADIUS];
+    uint32_t top;
+    uint32_t rows;
+
+    drp_lib_ctl->load_time = 0;
+    cpu_timer.reset();
+    for (uint32_t idx = 0; idx < R_DK2_TILE_NUM; idx++) {
+        get_stripe(drp_lib_ctl->dst.height, R_DK2_TILE_NUM, 1, idx, &top, &rows);
+        if (rows != 0) {
+            integral_box_blur(&drp_lib_ctl->src, &drp_lib_ctl->dst, radius, top, rows);
+        }
+    }
+    drp_lib_ctl->run_time = cpu_timer.read_us();
+}
+
+//
+// Register DRP function
+//
+// Releases the configuration data of the previous mode. It stays cached in
+// drp_lib_work_memory, so the libraries the next mode shares are not copied again.
+static void init_drp_work_memory(void) {
+    for (uint32_t i = 0; i < DRP_LIB_MAX; i++) {
+        config_memory_put(drp_lib[i].lib_handle);
+        config_memory_put(drp_lib[i].sub_handle);
+        drp_lib[i].lib_handle = CONFIG_HANDLE_NONE;
+        drp_lib[i].sub_handle = CONFIG_HANDLE_NONE;
+    }
+    cpu_state_memory_top = cpu_state_memory;
+}
+
+// Cleaned by the buffer ownership layer when the DRP loads it
+static bool get_configuration_data(config_handle_t * p_handle, uint32_t drp_lib_no) {
+#if RAM_TABLE_DYNAMIC_LOADING
+    const drp_lib_func * p_drp_lib_func = &drp_lib_func_tbl[drp_lib_no];
+
+    // Left in ROM by the placement when the arena is short
+    *p_handle = CONFIG_HANDLE_NONE;
+    if (mem_item[MEM_ITEM_CONFIG + drp_lib_no].tier == MEM_TIER_ROM) {
+        return true;
+    }
+    *p_handle = config_memory_get(p_drp_lib_func->lib_bin, p_drp_lib_func->lib_bin_size);
+    if (*p_handle == CONFIG_HANDLE_NONE) {
+        printf("drp_lib_work_memory size error (%s)\r\n", p_drp_lib_func->lib_name);
+        return false;
+    }
+#else
+    (void)p_handle;
+    (void)drp_lib_no;
+#endif
+    return true;
+}
+
+// The entries may have been moved by compaction since set_drp_func
+static void set_configuration_data(drp_lib_ctl_t * p_drp_lib) {
+    const drp_lib_func * p_drp_lib_func = &drp_lib_func_tbl[p_drp_lib->drp_lib_no];
+
+    // Data without a handle is used in ROM
+    p_drp_lib->p_drp_lib_bin = (uint8_t *)p_drp_lib_func->lib_bin;
+    p_drp_lib->p_drp_sub_bin = NULL;
+    if (p_drp_lib_func->sub_lib_no != DRP_LIB_NONE) {
+        p_drp_lib->p_drp_sub_bin = (uint8_t *)drp_lib_func_tbl[p_drp_lib_func->sub_lib_no].lib_bin;
+    }
+#if RAM_TABLE_DYNAMIC_LOADING
+    if (p_drp_lib->lib_handle != CONFIG_HANDLE_NONE) {
+        p_drp_lib->p_drp_lib_bin = config_memory_addr(p_drp_lib->lib_handle);
+    }
+    if (p_drp_lib->sub_handle != CONFIG_HANDLE_NONE) {
+        p_drp_lib->p_drp_sub_bin = config_memory_addr(p_drp_lib->sub_handle);
+    }
+#endif
+}
+
+static uint32_t get_state_free(void) {
+    return ((uint32_t)cpu_state_memory + CPU_STATE_SIZE) - (uint32_t)cpu_state_memory_top;
+}
+
+// Returns NULL when the state arena is full
+static uint8_t * get_state_memory(uint32_t size) {
+    uint8_t * ret_addr = cpu_state_memory_top;
+
+    if (((size + 31ul) & ~31ul) > get_state_free()) {
+        printf("cpu_state_memory size error\r\n");
+        return NULL;
+    }
+    cpu_state_memory_top = (uint8_t *)(((uint32_t)cpu_state_memory_top + size + 31ul) & ~31ul);
+
+    return ret_addr;
+}
+
+// Every frame slot after the first gets its own copies of the work buffers the stages use, carved
+// from the state arena after the state of the mode. Returns the number of slots that fit, at most frame_depth.
+static uint32_t init_slot_work(uint32_t drp_lib_num) {
+    uint8_t * const work_buf[2] = {fbuf_work0, fbuf_work1};
+    bool used[2] = {false, false};
+    uint32_t size = 0;
+
+    // The slots a mode does not use keep the buffers of slot 0
+    for (uint32_t slot = 0; slot < FRAME_IN_FLIGHT_MAX; slot++) {
+        slot_work[slot][0] = fbuf_work0;
+        slot_work[slot][1] = fbuf_work1;
+    }
+    if (frame_depth < 2) {
+        return frame_depth;
+    }
+
+    for (uint32_t i = 0; i < drp_lib_num; i++) {
+        const uint8_t * const view_base[] = {drp_lib[i].src.base, drp_lib[i].dst.base, drp_lib[i].src_view.base};
+
+        for (uint32_t v = 0; v < (sizeof(view_base) / sizeof(view_base[0])); v++) {
+            for (uint32_t w = 0; w < 2; w++) {
+                if ((view_base[v] >= work_buf[w]) && (view_base[v] < (work_buf[w] + FRAME_BUFFER_SIZE))) {
+                    used[w] = true;
+                }
+            }
+        }
+    }
+    for (uint32_t w = 0; w < 2; w++) {
+        if (used[w]) {
+            size += FRAME_BUFFER_SIZE;
+        }
+    }
+    for (uint32_t slot = 1; slot < frame_depth; slot++) {
+        if (size > get_state_free()) {
+            return slot;
+        }
+        for (uint32_t w = 0; w < 2; w++) {
+            if (used[w]) {
+                slot_work[slot][w] = get_state_memory(FRAME_BUFFER_SIZE);
+            }
+        }
+    }
+
+    return frame_depth;
+}
+
+// Returns false when the configuration data does not fit in drp_lib_work_memory, the state or the work
+// area of the library does not fit in the state arena or a strided source has no room for its staging buffer there
+static bool set_drp_func(drp_lib_ctl_t * p_drp_lib, uint32_t drp_lib_no, image_view_t src, image_view_t dst) {
+    const drp_lib_func * p_drp_lib_func = &drp_lib_func_tbl[drp_lib_no];
+
+    p_drp_lib->drp_lib_no = drp_lib_no;
+    p_drp_lib->src = src;
+    p_drp_lib->dst = dst;
+    p_drp_lib->src_view.base = NULL;
+    p_drp_lib->guide.base = NULL;
+    p_drp_lib->stripe_mask = (1u << R_DK2_TILE_NUM) - 1;
+    p_drp_lib->cpu_resize = false;
+    if (drp_lib_no == DRP_LIB_RESIZEBILINEARF) {
+        p_drp_lib->cpu_resize = !is_resize_on_drp(&src, &dst);
+    }
+
+    // The work area is shared by the frame slots like the staging buffer below
+    p_drp_lib->work.base = NULL;
+    if (!p_drp_lib->cpu_resize && (get_drp_work_size(drp_lib_no, &src) != 0)) {
+        uint32_t work_size = get_drp_work_size(drp_lib_no, &src);
+        uint8_t * p_work = get_state_memory(work_size);
+
+        if (p_work != NULL) {
+            p_drp_lib->work = image_view(p_work, work_size, 1, work_size);
+        } else if (drp_lib_no == DRP_LIB_RESIZEBILINEARF) {
+            // Without room for the staged stripes the resize runs on the CPU
+            p_drp_lib->cpu_resize = true;
+        } else {
+            return false;
+        }
+    }
+    p_drp_lib->tiles = stream[stream_num - 1].tiles;
+    if ((p_drp_lib->tiles != TILE_GROUP_ALL) && (p_drp_lib_func->lib_bin != NULL) &&
+        !p_drp_lib_func->tile_group && !p_drp_lib->cpu_resize) {
+        printf("%s needs the whole array\r\n", p_drp_lib_func->lib_name);
+        return false;
+    }
+    if (p_drp_lib->cpu_resize && (dst.width > RESIZE_WIDTH_MAX)) {
+        printf("%s is limited to %u pixels wide on the CPU\r\n", p_drp_lib_func->lib_name, (unsigned int)RESIZE_WIDTH_MAX);
+        return false;
+    }
+    if (((drp_lib_no == DRP_LIB_ADAPTIVETH) || (drp_lib_no == DRP_LIB_BOXBLUR)) && (src.width > INTEGRAL_WIDTH_MAX)) {
+        printf("%s is limited to %u pixels wide\r\n", p_drp_lib_func->lib_name, (unsigned int)INTEGRAL_WIDTH_MAX);
+        return false;
+    }
+
+    // A stage run on the CPU needs no configuration data
+    p_drp_lib->p_drp_lib_bin = NULL;
+    p_drp_lib->p_drp_sub_bin = NULL;
+    if ((p_drp_lib_func->lib_bin != NULL) && !p_drp_lib->cpu_resize) {
+        if (!get_configuration_data(&p_drp_lib->lib_handle, drp_lib_no)) {
+            return false;
+        }
+        if ((p_drp_lib_func->sub_lib_no != DRP_LIB_NONE) &&
+            !get_configuration_data(&p_drp_lib->sub_handle, p_drp_lib_func->sub_lib_no)) {
+            return false;
+        }
+    }
+    p_drp_lib->p_temporal = NULL;
+    if (p_drp_lib_func->state_bpp != 0) {
+        // The state is shared by all frame slots and reseeded by the first frame after every mode change
+        uint8_t * p_state = get_state_memory(src.width * src.height * p_drp_lib_func->state_bpp);
+
+        if (p_state == NULL) {
+            return false;
+        }
+        p_drp_lib->p_temporal = &temporal_state[p_drp_lib - &drp_lib[0]];
+        temporal_init(p_drp_lib->p_temporal, p_state, src.width, src.height);
+    }
+
+    // A strided view is consumed in place when the library takes a stride, otherwise it is packed by the CPU
+    // into a staging buffer from the state arena when the stage starts. The frame slots share the buffer,
+    // the stage runs on one frame at a time.
+    if (!image_view_is_packed(&src) && !p_drp_lib_func->src_stride && !p_drp_lib->cpu_resize) {
+        uint8_t * p_staging = get_state_memory(src.width * src.height);
+
+        if (p_staging == NULL) {
+            return false;
+        }
+        p_drp_lib->src_view = src;
+        p_drp_lib->src = image_view(p_staging, src.width, src.height, src.width);
+    }
+
+    return true;
+}
+
+// The stages registered from first on form a new stream on the given tile group.
+// Returns false when all the streams are in use.
+static bool begin_stream(uint32_t first, uint32_t tiles) {
+    if (stream[stream_num - 1].first != first) {
+        if (stream_num >= STREAM_MAX) {
+            printf("stream_num error\r\n");
+            return false;
+        }
+        stream[stream_num - 1].end = first;
+        stream_num++;
+    }
+    stream[stream_num - 1].first = first;
+    stream[stream_num - 1].tiles = tiles;
+
+    return true;
+}
+
+static void end_stream(uint32_t end) {
+    stream[stream_num - 1].end = end;
+    for (uint32_t s = stream_num; s < STREAM_MAX; s++) {
+        stream[s].first = end;
+        stream[s].end   = end;
+    }
+}
+
+// The mode is skipped rather than run with a part of its libraries
+static void skip_drp_lib(uint32_t mode) {
+    printf("mode %u is skipped\r\n", (unsigned int)mode);
+    init_drp_work_memory();
+    overlay_clear();
+    blob_labeling_mode = false;
+    frame_depth = 1;
+    stream_num = 1;
+    begin_stream(0, TILE_GROUP_ALL);
+    end_stream(0);
+    init_slot_work(0);
+}
+
+static uint32_t init_drp_lib(uint32_t mode) {
+    uint32_t idx = 0;
+    uint32_t depth;
+    bool result = true;
+    image_view_t crop_view;
+    uint8_t * p_pyramid;
+    image_view_t level_view;
+    image_view_t coarse_view[2];
+    image_view_t frame_view[3];
+
+    init_drp_work_memory();
+    overlay_clear();
+    blob_labeling_mode = false;
+    frame_depth = 1;
+    stream_num = 1;
+    begin_stream(0, TILE_GROUP_ALL);
 
     switch (mode) {
         case 0:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_clat8);  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_clat8));  // Bayer2Grayscale
             break;
         case 1:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BINARIZATION,    fbuf_work0, fbuf_clat8);  // Binarization
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BINARIZATION,    FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // Binarization
+            blob_labeling_mode = true;                                                       // Labeling (CPU)
             break;
         case 2:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_MEDIANBLUR,      fbuf_work0, fbuf_work1);  // MedianBlur
-            set_drp_func(&drp_lib[idx++], DRP_LIB_CANNYCALCULATE,  fbuf_work1, fbuf_work0);  // CannyCalculate
-            set_drp_func(&drp_lib[idx++], DRP_LIB_CANNYHYSTERISIS, fbuf_work0, fbuf_clat8);  // CannyHysterisis
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_MEDIANBLUR,      FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_work1));  // MedianBlur
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_CANNYCALCULATE,  FRAME_VIEW(fbuf_work1), FRAME_VIEW(fbuf_work0));  // CannyCalculate
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_CANNYHYSTERISIS, FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // CannyHysterisis
             break;
         case 3:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_ERODE,           fbuf_work0, fbuf_clat8);  // Erode
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_ERODE,           FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // Erode
             break;
         case 4:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_DILATE,          fbuf_work0, fbuf_clat8);  // Dilate
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_DILATE,          FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // Dilate
             break;
         case 5:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_GAUSSIANBLUR,    fbuf_work0, fbuf_clat8);  // GaussianBlur
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_GAUSSIANBLUR,    FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // GaussianBlur
             break;
         case 6:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_SOBEL,           fbuf_work0, fbuf_clat8);  // Sobel
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_SOBEL,           FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // Sobel
             break;
         case 7:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_PREWITT,         fbuf_work0, fbuf_clat8);  // Prewitt
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_PREWITT,         FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // Prewitt
             break;
         case 8:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_LAPLACIAN,       fbuf_work0, fbuf_clat8);  // Laplacian
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_LAPLACIAN,       FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // Laplacian
             break;
         case 9:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_UNSHARPMASKING,  fbuf_work0, fbuf_clat8);  // UnsharpMasking
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_UNSHARPMASKING,  FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // UnsharpMasking
             break;
         case 10:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_CROPPING,        fbuf_work0, fbuf_work1);  // Cropping
-            set_drp_func(&drp_lib[idx++], DRP_LIB_RESIZEBILINEARF, fbuf_work1, fbuf_clat8);  // ResizeBilinearF
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            // The central quarter is handed over as a view and staged on the tiles the resize circuit leaves idle
+            crop_view = FRAME_VIEW(fbuf_work0);
+            crop_view = image_view_crop(&crop_view, VIDEO_PIXEL_HW / 4, VIDEO_PIXEL_VW / 4, VIDEO_PIXEL_HW / 2, VIDEO_PIXEL_VW / 2);
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_RESIZEBILINEARF, crop_view, FRAME_VIEW(fbuf_clat8));               // ResizeBilinearF
             break;
         case 11:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_HISTOGRAM,       fbuf_work0, fbuf_clat8);  // Histogram
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_HISTOGRAM,       FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // Histogram
             break;
         case 12:
-            set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, fbuf_bayer, fbuf_work0);  // Bayer2Grayscale
-            set_drp_func(&drp_lib[idx++], DRP_LIB_IMAGEROTATE,     fbuf_work0, fbuf_clat8);  // ImageRotate
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_IMAGEROTATE,     FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // ImageRotate
+            break;
+        case 13:
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BACKGROUND,      FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_work1));  // Background (CPU)
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BINARIZATION,    FRAME_VIEW(fbuf_work1), FRAME_VIEW(fbuf_clat8));  // Binarization
+            blob_labeling_mode = true;                                                       // Labeling (CPU)
+            frame_depth = 2;                                                                 // Background overlaps the DRP of the next frame
+            break;
+        case 14:
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_FRAMEDIFF,       FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_work1));  // FrameDiff (CPU)
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BINARIZATION,    FRAME_VIEW(fbuf_work1), FRAME_VIEW(fbuf_clat8));  // Binarization
+            frame_depth = 2;                                                                 // FrameDiff overlaps the DRP of the next frame
+            break;
+        case 15:
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_RUNNINGAVERAGE,  FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // RunningAverage (CPU)
+            frame_depth = 2;                                                                 // RunningAverage overlaps Bayer2Grayscale of the next frame
+            break;
+        case 16:
+            // Canny on the 1/4 level finds where the edges are, Sobel runs only on those stripes at full resolution
+            p_pyramid   = get_state_memory(pyramid_size(VIDEO_PIXEL_HW, VIDEO_PIXEL_VW));
+            level_view  = pyramid_level(p_pyramid, VIDEO_PIXEL_HW, VIDEO_PIXEL_VW, 2);
+            coarse_view[0] = image_view(get_state_memory(level_view.width * level_view.height), level_view.width, level_view.height, level_view.width);
+            coarse_view[1] = image_view(get_state_memory(level_view.width * level_view.height), level_view.width, level_view.height, level_view.width);
+            result &= (p_pyramid != NULL) && (coarse_view[0].base != NULL) && (coarse_view[1].base != NULL);
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_GAUSSIANBLUR,    FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_work1));  // GaussianBlur
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_PYRAMID,         FRAME_VIEW(fbuf_work1),
+                                   pyramid_view(p_pyramid, VIDEO_PIXEL_HW, VIDEO_PIXEL_VW));                 // Pyramid (CPU)
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_CANNYCALCULATE,  level_view,             coarse_view[0]);          // CannyCalculate
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_CANNYHYSTERISIS, coarse_view[0],         coarse_view[1]);          // CannyHysterisis
+            result &= set_drp_func(&drp_lib[idx],   DRP_LIB_SOBEL,           FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // Sobel
+            drp_lib[idx++].guide = coarse_view[1];
+            break;
+        case 17:
+            // Dual ROI: the upper and the lower half of the frame run as two streams on tiles 0-2 and 3-5
+            frame_view[0] = FRAME_VIEW(fbuf_bayer);
+            frame_view[1] = FRAME_VIEW(fbuf_work0);
+            frame_view[2] = FRAME_VIEW(fbuf_work1);
+            for (uint32_t s = 0; s < STREAM_MAX; s++) {
+                uint32_t top = (VIDEO_PIXEL_VW / STREAM_MAX) * s;
+                image_view_t bayer_roi = image_view_crop(&frame_view[0], 0, top, VIDEO_PIXEL_HW, VIDEO_PIXEL_VW / STREAM_MAX);
+                image_view_t work0_roi = image_view_crop(&frame_view[1], 0, top, VIDEO_PIXEL_HW, VIDEO_PIXEL_VW / STREAM_MAX);
+                image_view_t work1_roi = image_view_crop(&frame_view[2], 0, top, VIDEO_PIXEL_HW, VIDEO_PIXEL_VW / STREAM_MAX);
+                image_view_t clat8_roi = image_view(fbuf_clat8 + (FRAME_BUFFER_STRIDE * top), VIDEO_PIXEL_HW, VIDEO_PIXEL_VW / STREAM_MAX, FRAME_BUFFER_STRIDE);
+
+                result &= begin_stream(idx, (s == 0) ? TILE_GROUP_0 : TILE_GROUP_1);
+                result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, bayer_roi, work0_roi);  // Bayer2Grayscale
+                if (s == 0) {
+                    result &= set_drp_func(&drp_lib[idx++], DRP_LIB_GAUSSIANBLUR, work0_roi, work1_roi);  // GaussianBlur
+                    result &= set_drp_func(&drp_lib[idx++], DRP_LIB_SOBEL,        work1_roi, clat8_roi);  // Sobel
+                } else {
+                    result &= set_drp_func(&drp_lib[idx++], DRP_LIB_MEDIANBLUR,   work0_roi, work1_roi);  // MedianBlur
+                    result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BINARIZATION, work1_roi, clat8_roi);  // Binarization
+                }
+            }
+            frame_depth = 2;                                                                 // A stream does not wait for the other one
+            break;
+        case 18:
+        case 19:
+            // Local mean over an adjustable window from the summed-area table: adaptive threshold or box blur
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            if (mode == 18) {
+                result &= set_drp_func(&drp_lib[idx++], DRP_LIB_ADAPTIVETH,  FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // AdaptiveThresh (CPU)
+            } else {
+                result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BOXBLUR,     FRAME_VIEW(fbuf_work0), FRAME_VIEW(fbuf_clat8));  // BoxBlur (CPU)
+            }
+            frame_depth = 2;                                                                 // The CPU stage overlaps Bayer2Grayscale of the next frame
+            break;
+        case 20:
+            // The central quarter is copied out by Cropping, as UnsharpMasking cannot read a strided view, sharpened and zoomed 2x
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            crop_view = FRAME_VIEW(fbuf_work0);
+            crop_view = image_view_crop(&crop_view, VIDEO_PIXEL_HW / 4, VIDEO_PIXEL_VW / 4, VIDEO_PIXEL_HW / 2, VIDEO_PIXEL_VW / 2);
+            frame_view[0] = image_view(fbuf_work1, VIDEO_PIXEL_HW / 2, VIDEO_PIXEL_VW / 2, VIDEO_PIXEL_HW / 2);
+            frame_view[1] = image_view(fbuf_work0, VIDEO_PIXEL_HW / 2, VIDEO_PIXEL_VW / 2, VIDEO_PIXEL_HW / 2);
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_CROPPING,        crop_view,     frame_view[0]);                    // Cropping
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_UNSHARPMASKING,  frame_view[0], frame_view[1]);                    // UnsharpMasking
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_RESIZEBILINEARF, frame_view[1], FRAME_VIEW(fbuf_clat8));          // ResizeBilinearF
+            break;
+        case 21:
+            // A 4/3 zoom of the central 480x360, a ratio the DRP library has no code for: resized on the CPU
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_BAYER2GRAYSCALE, FRAME_VIEW(fbuf_bayer), FRAME_VIEW(fbuf_work0));  // Bayer2Grayscale
+            crop_view = FRAME_VIEW(fbuf_work0);
+            crop_view = image_view_crop(&crop_view, VIDEO_PIXEL_HW / 8, VIDEO_PIXEL_VW / 8, (VIDEO_PIXEL_HW * 3) / 4, (VIDEO_PIXEL_VW * 3) / 4);
+            result &= set_drp_func(&drp_lib[idx++], DRP_LIB_RESIZEBILINEARF, crop_view, FRAME_VIEW(fbuf_clat8));               // ResizeBilinearF (CPU)
+            frame_depth = 2;                                                                 // The CPU stage overlaps Bayer2Grayscale of the next frame
             break;
         default:
             // do nothing
             break;
     }
 
+    if (!result) {
+        skip_drp_lib(mode);
+        return 0;
+    }
+    end_stream(idx);
+
+    // The depth set with the console command depth takes the place of the default of the mode
+    if (depth_req[mode] != 0) {
+        frame_depth = depth_req[mode];
+    }
+    if (frame_depth > FRAME_IN_FLIGHT_MAX) {
+        frame_depth = FRAME_IN_FLIGHT_MAX;
+    }
+    depth = init_slot_work(idx);
+    if (depth < frame_depth) {
+        printf("mode %u runs %u frames in flight, the state arena is short of more frame slots\r\n",
+               (unsigned int)mode, (unsigned int)depth);
+        frame_depth = depth;
+    }
+
     return idx;
 }
 
 //
-// Drawing of DRP processing time
+// Run DRP function
 //
-static void draw_str(const char * str, uint32_t line) {
-    ascii_font.DrawStr(str, 5, 5 + (AsciiFont::CHAR_PIX_HEIGHT + 1) * 2 * line, 1, 2);
+static void view_cpu_begin(const image_view_t * p_view, uint32_t access) {
+    buffer_cpu_begin(p_view->base, image_view_span(p_view), access);
+}
+
+static void view_cpu_end(const image_view_t * p_view, uint32_t access) {
+    buffer_cpu_end(p_view->base, image_view_span(p_view), access);
+}
+
+static void view_device_begin(const image_view_t * p_view, uint32_t access) {
+    buffer_device_begin(p_view->base, image_view_span(p_view), access);
+}
+
+static void view_device_end(const image_view_t * p_view, uint32_t access) {
+    buffer_device_end(p_view->base, image_view_span(p_view), access);
+}
+
+static bool is_cpu_stage(const drp_lib_ctl_t * p_drp_lib) {
+    return ((drp_lib_func_tbl[p_drp_lib->drp_lib_no].lib_bin == NULL) || p_drp_lib->cpu_resize);
+}
+
+static void pack_view(const image_view_t * p_src, const image_view_t * p_dst) {
+    view_cpu_begin(p_src, BUFFER_READ);
+    view_cpu_begin(p_dst, BUFFER_WRITE);
+    for (uint32_t y = 0; y < p_src->height; y++) {
+        memcpy(image_view_row(p_dst, y), image_view_row(p_src, y), p_src->width);
+    }
+    view_cpu_end(p_dst, BUFFER_WRITE);
+    view_cpu_end(p_src, BUFFER_READ);
+}
+
+static void set_drp_lib_owner(const drp_lib_ctl_t * p_drp_lib) {
+#if RAM_TABLE_DYNAMIC_LOADING
+    const drp_lib_func * p_drp_lib_func = &drp_lib_func_tbl[p_drp_lib->drp_lib_no];
+
+    // The configuration data copied by config_memory_get is cleaned on its first load
+    if (p_drp_lib->lib_handle != CONFIG_HANDLE_NONE) {
+        buffer_device_begin(p_drp_lib->p_drp_lib_bin, p_drp_lib_func->lib_bin_size, BUFFER_READ);
+    }
+    if (p_drp_lib->sub_handle != CONFIG_HANDLE_NONE) {
+        buffer_device_begin(p_drp_lib->p_drp_sub_bin, drp_lib_func_tbl[p_drp_lib_func->sub_lib_no].lib_bin_size, BUFFER_READ);
+    }
+#else
+    (void)p_drp_lib;
+#endif
+}
+
+// Runs a CPU stage to the end
+static void run_cpu_func(drp_lib_ctl_t * p_drp_lib) {
+    drp_trace(DRP_TRACE_STAGE_BEGIN, DRP_TRACE_TRACK_CPU, p_drp_lib->drp_lib_no);
+    p_drp_lib->load_num = 0;
+    view_cpu_begin(&p_drp_lib->src, BUFFER_READ);
+    view_cpu_begin(&p_drp_lib->dst, BUFFER_WRITE);
+    if (p_drp_lib->cpu_resize) {
+        resize_bilinear_cpu(p_drp_lib);
+    } else {
+        drp_lib_func_tbl[p_drp_lib->drp_lib_no].p_func(p_drp_lib);
+    }
+    view_cpu_end(&p_drp_lib->dst, BUFFER_WRITE);
+    view_cpu_end(&p_drp_lib->src, BUFFER_READ);
+    drp_trace(DRP_TRACE_STAGE_END, DRP_TRACE_TRACK_CPU, p_drp_lib->drp_lib_no);
 }
 
-static void draw_processing_time(uint32_t drp_lib_num) {
+// Picks the stripes of a guided stage: a stripe runs when the guide has a pixel set
+// in its rows or in the row next to them. The output of the other stripes is cleared.
+// With no stripe to run, the stage starts no circuit and its job completes at once.
+static void select_stripes(drp_lib_ctl_t * p_drp_lib) {
+    const image_view_t * p_guide = &p_drp_lib->guide;
+    const image_view_t * p_dst = &p_drp_lib->dst;
+    uint32_t stripe_num = count_tiles(p_drp_lib->tiles);
+    uint32_t stripe_rows = p_dst->height / stripe_num;
+    uint32_t mask = 0;
+    image_view_t stripe;
+
+    view_cpu_begin(p_guide, BUFFER_READ);
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        uint32_t top = (p_guide->height * idx) / stripe_num;
+        uint32_t end = (p_guide->height * (idx + 1)) / stripe_num;
+
+        top = (top > 0) ? (top - 1) : 0;
+        end = (end < p_guide->height) ? (end + 1) : end;
+        for (uint32_t y = top; (y < end) && ((mask & (1u << idx)) == 0); y++) {
+            const uint8_t * p_row = image_view_row(p_guide, y);
+            for (uint32_t x = 0; x < p_guide->width; x++) {
+                if (p_row[x] != 0) {
+                    mask |= (1u << idx);
+                    break;
+                }
+            }
+        }
+    }
+    view_cpu_end(p_guide, BUFFER_READ);
+
+    for (uint32_t idx = 0; idx < stripe_num; idx++) {
+        if ((mask & (1u << idx)) == 0) {
+            stripe = image_view_crop(p_dst, 0, stripe_rows * idx, p_dst->width, stripe_rows);
+            view_cpu_begin(&stripe, BUFFER_WRITE);
+            for (uint32_t y = 0; y < stripe.height; y++) {
+                memset(image_view_row(&stripe, y), 0, stripe.width);
+            }
+            view_cpu_end(&stripe, BUFFER_WRITE);
+        }
+    }
+    p_drp_lib->stripe_mask = mask;
+}
+
+// Starts a DRP stage of stream s. It returns while the last phase still runs as p_drp_lib->job.
+static void start_drp_func(drp_lib_ctl_t * p_drp_lib, uint32_t s) {
+    drp_trace(DRP_TRACE_STAGE_BEGIN, DRP_TRACE_TRACK_DRP + s, p_drp_lib->drp_lib_no);
+    drp_trace(DRP_TRACE_STAGE_TILES, p_drp_lib->tiles, DRP_TRACE_TRACK_DRP + s);
+    p_drp_lib->pack_time = 0;
+    p_drp_lib->stalled   = false;
+
+    // Only a strided view that the library cannot read is copied, and the copy is counted as run time
+    if (p_drp_lib->src_view.base != NULL) {
+        t.reset();
+        pack_view(&p_drp_lib->src_view, &p_drp_lib->src);
+        p_drp_lib->pack_time = t.read_us();
+    }
+    if (p_drp_lib->guide.base != NULL) {
+        select_stripes(p_drp_lib);
+    }
+    set_configuration_data(p_drp_lib);
+    set_drp_lib_owner(p_drp_lib);
+    p_drp_lib->load_num = drp_job_load_count();
+    view_device_begin(&p_drp_lib->src, BUFFER_READ);
+    view_device_begin(&p_drp_lib->dst, BUFFER_WRITE);
+    if (p_drp_lib->work.base != NULL) {
+        view_device_begin(&p_drp_lib->work, BUFFER_READ_WRITE);
+    }
+    drp_lib_func_tbl[p_drp_lib->drp_lib_no].p_func(p_drp_lib);
+}
+
+// Called once p_drp_lib->job has completed
+static void finish_drp_func(drp_lib_ctl_t * p_drp_lib, uint32_t s) {
+    if (p_drp_lib->work.base != NULL) {
+        view_device_end(&p_drp_lib->work, BUFFER_READ_WRITE);
+    }
+    view_device_end(&p_drp_lib->dst, BUFFER_WRITE);
+    view_device_end(&p_drp_lib->src, BUFFER_READ);
+    p_drp_lib->run_time += p_drp_lib->pack_time;
+    p_drp_lib->load_num = drp_job_load_count() - p_drp_lib->load_num;
+    drp_trace(DRP_TRACE_STAGE_END, DRP_TRACE_TRACK_DRP + s, p_drp_lib->drp_lib_no);
+}
+
+// Called instead of finish_drp_func for a stalled stage. The circuits are unloaded whatever
+// their state, so the next stage can load the tiles. The continuation of the job never runs.
+static void recover_drp_func(drp_lib_ctl_t * p_drp_lib, uint32_t s) {
+    drp_trace(DRP_TRACE_STALL, p_drp_lib->tiles, p_drp_lib->drp_lib_no);
+    drp_job_abort(&p_drp_lib->job);
+    unload_tiles(p_drp_lib->tiles);
+    if (p_drp_lib->tiles == TILE_GROUP_ALL) {
+        // Nothing else runs on the array, the driver is reset in case a circuit did not unload
+        R_DK2_Uninitialize();
+        R_DK2_Initialize();
+        memset(drp_lib_id, 0, sizeof(drp_lib_id));
+    }
+    drp_job_unlock_tiles(p_drp_lib->tiles);
+    if (p_drp_lib->work.base != NULL) {
+        view_device_end(&p_drp_lib->work, BUFFER_READ_WRITE);
+    }
+    view_device_end(&p_drp_lib->dst, BUFFER_WRITE);
+    view_device_end(&p_drp_lib->src, BUFFER_READ);
+    p_drp_lib->run_time = (exec_timer.read_us() - p_drp_lib->run_start) + p_drp_lib->pack_time;
+    p_drp_lib->load_num = drp_job_load_count() - p_drp_lib->load_num;
+    drp_trace(DRP_TRACE_STAGE_END, DRP_TRACE_TRACK_DRP + s, p_drp_lib->drp_lib_no);
+}
+
+//
+// Drawing of DRP processing time
+//
+static void draw_processing_time(const drp_lib_ctl_t * p_drp_lib, uint32_t drp_lib_num) {
     char str[64];
     uint32_t i;
     uint32_t time_sum = 0;
-    drp_lib_ctl_t * p_drp_lib = &drp_lib[0];
+    uint32_t load_time;  // 0.1ms unit
+    uint32_t run_time;   // 0.1ms unit
 
+    // Only the characters that changed since the previous frame are redrawn
     for (i = 0; i < drp_lib_num; i++) {
-        sprintf(str, "%s : Load %2.1fms + Run %2.1fms", drp_lib_func_tbl[p_drp_lib->drp_lib_no].lib_name,
-                (float_t)p_drp_lib->load_time / 1000, (float_t)p_drp_lib->run_time / 1000);
-        draw_str(str, i);
+        load_time = (p_drp_lib->load_time + 50) / 100;
+        run_time  = (p_drp_lib->run_time + 50) / 100;
+        sprintf(str, "%s : Load %2d.%dms + Run %2d.%dms", drp_lib_func_tbl[p_drp_lib->drp_lib_no].lib_name,
+                (int)(load_time / 10), (int)(load_time % 10), (int)(run_time / 10), (int)(run_time % 10));
+        overlay_draw_text(i, str);
         time_sum += p_drp_lib->load_time;
         time_sum += p_drp_lib->run_time;
         p_drp_lib++;
     }
-    sprintf(str, "Total           : %2.1fms", (float_t)time_sum / 1000);
-    draw_str(str, i);
+    time_sum = (time_sum + 50) / 100;
+    sprintf(str, "Total           : %2d.%dms", (int)(time_sum / 10), (int)(time_sum % 10));
+    overlay_draw_text(i, str);
+}
+
+static void draw_pipeline_time(uint32_t line) {
+    char str[64];
+    uint32_t latency = (exec_latency + 50) / 100;  // 0.1ms unit
+    uint32_t period  = (exec_period + 50) / 100;   // 0.1ms unit
+
+    // Latency is camera to LCD (camera input to the last stage without a display),
+    // period is the interval between finished frames
+    if (glass_latency != 0) {
+        latency = (glass_latency + 50) / 100;
+    }
+    sprintf(str, "Pipeline x%d     : Latency %2d.%dms Period %2d.%dms", (int)frame_depth,
+            (int)(latency / 10), (int)(latency % 10), (int)(period / 10), (int)(period % 10));
+    overlay_draw_text(line, str);
+}
+
+// One line per stream: frames per second and the latency from the start of the frame
+static void draw_stream_time(uint32_t line) {
+    char str[64];
+
+    for (uint32_t s = 0; s < stream_num; s++) {
+        uint32_t latency = (stream[s].latency + 50) / 100;  // 0.1ms unit
+        uint32_t fps     = (stream[s].period != 0) ? ((10000000 + (stream[s].period / 2)) / stream[s].period) : 0;  // 0.1fps unit
+
+        sprintf(str, "Stream %d (%d-%d)  : Latency %2d.%dms %2d.%dfps", (int)s,
+                (int)__builtin_ctz(stream[s].tiles), (int)(31 - __builtin_clz(stream[s].tiles)),
+                (int)(latency / 10), (int)(latency % 10), (int)(fps / 10), (int)(fps % 10));
+        overlay_draw_text(line + s, str);
+    }
+}
+
+// Shown once a stage has stalled
+static void draw_stall(uint32_t line) {
+    char str[64];
+
+    if (stall_count == 0) {
+        return;
+    }
+    sprintf(str, "DRP stall       : %3d retried %3d skipped", (int)(stall_count - stall_skipped), (int)stall_skipped);
+    overlay_draw_text(line, str);
+}
+
+static void draw_cache_maintenance(uint32_t line) {
+    char str[64];
+    buffer_owner_stats_t stats;
+
+    buffer_owner_get_stats(&stats, true);
+#if BUFFER_OWNER_DEBUG
+    sprintf(str, "Cache / frame   : Clean %4dKB Inv %4dKB Err %d", (int)(stats.clean_bytes / 1024),
+            (int)(stats.invalidate_bytes / 1024), (int)stats.violation);
+#else
+    sprintf(str, "Cache / frame   : Clean %4dKB Inv %4dKB", (int)(stats.clean_bytes / 1024),
+            (int)(stats.invalidate_bytes / 1024));
+#endif
+    overlay_draw_text(line, str);
+}
+
+//
+// Connected-component labeling of the binarized image
+// Runs on the CPU while the next frame is processed by the DRP.
+//
+static void blob_task(void) {
+    blob_timer.start();
+
+    while (true) {
+        ThisThread::flags_wait_all(BLOB_FLG_START);
+        blob_timer.reset();
+        view_cpu_begin(&blob_view, BUFFER_READ);
+        blob_labeling(blob_view.base, blob_view.width, blob_view.height, blob_view.stride, BLOB_MIN_AREA, &blob_result);
+        view_cpu_end(&blob_view, BUFFER_READ);
+        blob_time = blob_timer.read_us();
+        drpTask.flags_set(DRP_FLG_BLOB_DONE);
+    }
+}
+
+static void start_blob_labeling(const image_view_t * p_src) {
+    blob_view = *p_src;
+    blob_busy = true;
+    blobTask.flags_set(BLOB_FLG_START);
+}
+
+static void draw_blob_features(uint32_t line) {
+    char str[64];
+    uint32_t time = (blob_time + 50) / 100;  // 0.1ms unit
+
+    overlay_clear_shapes();
+    for (uint32_t i = 0; (i < blob_result.feature_num) && (i < BLOB_DRAW_MAX); i++) {
+        blob_feature_t * p_feature = &blob_result.feature[i];
+
+        overlay_draw_rect(p_feature->x_min, p_feature->y_min,
+                          p_feature->x_max - p_feature->x_min + 1, p_feature->y_max - p_feature->y_min + 1, 1);
+    }
+    sprintf(str, "Labeling        : %2d.%dms %3d blobs%s", (int)(time / 10), (int)(time % 10),
+            (int)blob_result.blob_num, blob_result.overflow ? "+" : "");
+    overlay_draw_text(line, str);
+}
+
+static void wait_blob_labeling(uint32_t line) {
+    if (blob_busy) {
+        ThisThread::flags_wait_all(DRP_FLG_BLOB_DONE);
+        blob_busy = false;
+        draw_blob_features(line);
+    }
 }
 
 //
@@ -1025,56 +2235,1132 @@ static void button_fall(void) {
     event_time.reset();
 }
 
+//
+// Buffer ownership
+// Cache maintenance is done by the buffer ownership layer on the ranges that change hands.
+//
+static void register_buffer(void * p_base, uint32_t size, bool cached, const char * p_name) {
+    if (!buffer_owner_register(p_base, size, cached)) {
+        printf("buffer_owner: %s is not tracked (BUFFER_OWNER_REGION_MAX, BUFFER_OWNER_CHUNK_MAX)\r\n", p_name);
+    }
+}
+
+static void init_buffer_owner(void) {
+    register_buffer(fbuf_bayer, sizeof(fbuf_bayer), true, "fbuf_bayer");
+    register_buffer(tier_ocram, sizeof(tier_ocram), true, "tier_ocram");
+#if MBED_CONF_APP_TIER_EXTRAM_SIZE > 0
+    register_buffer(tier_extram, sizeof(tier_extram), true, "tier_extram");
+#endif
+    register_buffer(fbuf_clat8, sizeof(fbuf_clat8), true, "fbuf_clat8");
+#if RAM_TABLE_DYNAMIC_LOADING
+    register_buffer(drp_lib_work_memory, sizeof(drp_lib_work_memory), true, "drp_lib_work_memory");
+    config_memory_init(drp_lib_work_memory, sizeof(drp_lib_work_memory));
+#endif
+    register_buffer(fbuf_overlay, sizeof(fbuf_overlay), false, "fbuf_overlay");
+
+    // The camera writes fbuf_bayer from now on
+    buffer_device_begin(fbuf_bayer, sizeof(fbuf_bayer), BUFFER_WRITE);
+}
+
+//
+// Memory placement
+// The work buffers, the CPU state and the configuration data are placed across the memory tiers
+// on every mode change, by the bytes the mode accessed per frame on its previous visit.
+//
+static void init_memory_tier(void) {
+    static const char * const work_name[] = {"work0", "work1"};
+
+    mem_tier[MEM_TIER_ROM].p_probe    = drp_lib_func_tbl[DRP_LIB_BAYER2GRAYSCALE].lib_bin;
+    mem_tier[MEM_TIER_ROM].probe_size = drp_lib_func_tbl[DRP_LIB_BAYER2GRAYSCALE].lib_bin_size;
+    memory_tier_init(mem_tier, MEM_TIER_NUM);
+
+    for (uint32_t i = 0; i < 2; i++) {
+        mem_item[MEM_ITEM_WORK0 + i].name      = work_name[i];
+        mem_item[MEM_ITEM_WORK0 + i].size      = FRAME_BUFFER_SIZE;
+        mem_item[MEM_ITEM_WORK0 + i].tier_mask = (1u << MEM_TIER_OCRAM) | (1u << MEM_TIER_EXTRAM);
+    }
+    mem_item[MEM_ITEM_STATE].name      = "state";
+    mem_item[MEM_ITEM_STATE].size      = CPU_STATE_SIZE;
+    mem_item[MEM_ITEM_STATE].tier_mask = (1u << MEM_TIER_OCRAM) | (1u << MEM_TIER_EXTRAM);
+    for (uint32_t i = 0; i < DRP_LIB_NUM; i++) {
+        mem_item[MEM_ITEM_CONFIG + i].name = drp_lib_func_tbl[i].lib_name;
+        mem_item[MEM_ITEM_CONFIG + i].size = drp_lib_func_tbl[i].lib_bin_size;
+        mem_item[MEM_ITEM_CONFIG + i].tier = MEMORY_TIER_NONE;
+    }
+}
+
+static uint32_t get_work_item(const uint8_t * p_addr) {
+    uint8_t * const work_buf[] = {fbuf_work0, fbuf_work1};
+
+    for (uint32_t i = 0; i < 2; i++) {
+        if ((p_addr >= work_buf[i]) && (p_addr < (work_buf[i] + FRAME_BUFFER_SIZE))) {
+            return MEM_ITEM_WORK0 + i;
+        }
+    }
+    // The work buffers of the frame slots after the first
+    if ((p_addr >= cpu_state_memory) && (p_addr < (cpu_state_memory + CPU_STATE_SIZE))) {
+        return MEM_ITEM_STATE;
+    }
+    return MEM_ITEM_NUM;
+}
+
+// Telemetry of a finished frame
+static void record_memory_access(const frame_slot_t * p_slot, uint32_t drp_lib_num) {
+    mem_mode_t * p_mode = &mem_mode[mem_cur_mode];
+    uint32_t access[MEM_ITEM_NUM + 1];  // The last one collects the buffers that are not placed
+
+    memset(access, 0, sizeof(access));
+    for (uint32_t i = 0; i < drp_lib_num; i++) {
+        const drp_lib_ctl_t * p_ctl = &p_slot->ctl[i];
+        const drp_lib_func * p_drp_lib_func = &drp_lib_func_tbl[p_ctl->drp_lib_no];
+
+        access[get_work_item(p_ctl->src.base)] += image_view_span(&p_ctl->src);
+        access[get_work_item(p_ctl->dst.base)] += image_view_span(&p_ctl->dst);
+        if (p_ctl->src_view.base != NULL) {
+            access[get_work_item(p_ctl->src_view.base)] += image_view_span(&p_ctl->src_view);
+        }
+        if (p_ctl->p_temporal != NULL) {
+            access[MEM_ITEM_STATE] += p_ctl->src.width * p_ctl->src.height * p_drp_lib_func->state_bpp * 2;
+        }
+        // A stage with a second library loads both in turn
+        if (p_drp_lib_func->sub_lib_no == DRP_LIB_NONE) {
+            access[MEM_ITEM_CONFIG + p_ctl->drp_lib_no] += p_ctl->load_num * p_drp_lib_func->lib_bin_size;
+        } else {
+            access[MEM_ITEM_CONFIG + p_ctl->drp_lib_no] += ((p_ctl->load_num + 1) / 2) * p_drp_lib_func->lib_bin_size;
+            access[MEM_ITEM_CONFIG + p_drp_lib_func->sub_lib_no] +=
+                (p_ctl->load_num / 2) * drp_lib_func_tbl[p_drp_lib_func->sub_lib_no].lib_bin_size;
+        }
+    }
+
+    // Running averages with a weight of 1/8
+    for (uint32_t i = 0; i < MEM_ITEM_NUM; i++) {
+        if (p_mode->frames == 0) {
+            p_mode->access[i] = access[i];
+        } else {
+            p_mode->access[i] += (int32_t)(access[i] - p_mode->access[i]) / 8;
+        }
+    }
+    p_mode->frames++;
+}
+
+// Called on a mode change while nothing runs. Returns false when the tiers are short of the buffers.
+static bool place_memory(uint32_t mode) {
+    mem_mode_t * p_mode = &mem_mode[mode];
+
+    if ((mem_cur_mode <= DRP_MODE_MAX) && (mem_mode[mem_cur_mode].frames != 0)) {
+        mem_mode[mem_cur_mode].latency = exec_latency;
+    }
+    mem_cur_mode = mode;
+
+    // Only the configuration data the mode loaded competes for the arena, the rest is placed on demand
+    for (uint32_t i = 0; i < MEM_ITEM_NUM; i++) {
+        mem_item[i].access = p_mode->access[i];
+    }
+    for (uint32_t i = 0; i < DRP_LIB_NUM; i++) {
+        mem_item[MEM_ITEM_CONFIG + i].tier_mask = 0;
+        if ((p_mode->access[MEM_ITEM_CONFIG + i] != 0) && (drp_lib_func_tbl[i].lib_bin != NULL)) {
+            mem_item[MEM_ITEM_CONFIG + i].tier_mask = (1u << MEM_TIER_CONFIG) | (1u << MEM_TIER_ROM);
+        }
+    }
+
+    // What the placement of the previous visit costs with the latest telemetry
+    p_mode->predict_prev = 0;
+    if (p_mode->visited) {
+        for (uint32_t i = 0; i < MEM_ITEM_NUM; i++) {
+            mem_item[i].tier = (p_mode->tier[i] == 0xFF) ? MEMORY_TIER_NONE : p_mode->tier[i];
+        }
+        p_mode->predict_prev = memory_tier_predict(mem_tier, mem_item, MEM_ITEM_NUM);
+    }
+
+    if (!memory_tier_place(mem_tier, MEM_TIER_NUM, mem_item, MEM_ITEM_NUM)) {
+        printf("memory tier size error\r\n");
+        return false;
+    }
+    p_mode->predict = memory_tier_predict(mem_tier, mem_item, MEM_ITEM_NUM);
+    for (uint32_t i = 0; i < MEM_ITEM_NUM; i++) {
+        p_mode->tier[i] = (mem_item[i].tier == MEMORY_TIER_NONE) ? 0xFF : mem_item[i].tier;
+    }
+    p_mode->latency_prev = p_mode->visited ? p_mode->latency : 0;
+    p_mode->latency = 0;
+    p_mode->frames = 0;
+    p_mode->visited = true;
+
+    fbuf_work0 = mem_item[MEM_ITEM_WORK0 + 0].p_addr;
+    fbuf_work1 = mem_item[MEM_ITEM_WORK0 + 1].p_addr;
+    cpu_state_memory = mem_item[MEM_ITEM_STATE].p_addr;
+
+    return true;
+}
+
+//
+// Glass-to-glass latency
+//
+static void init_latency(void) {
+    histogram_init(&latency_hist[LATENCY_CAPTURE_START], 1000);
+    histogram_init(&latency_hist[LATENCY_PROCESSING],    2000);
+    histogram_init(&latency_hist[LATENCY_DISPLAY],       1000);
+    histogram_init(&latency_hist[LATENCY_TOTAL],         4000);
+    latency_dropped  = 0;
+    latency_replaced = 0;
+}
+
+static void stamp_frame(frame_slot_t * p_slot) {
+    core_util_critical_section_enter();
+    p_slot->capture_seq  = capture_seq;
+    p_slot->capture_time = capture_time;
+    core_util_critical_section_exit();
+
+    if ((latency_last_seq != 0) && ((p_slot->capture_seq - latency_last_seq) > 1)) {
+        latency_dropped += p_slot->capture_seq - latency_last_seq - 1;
+    }
+    latency_last_seq = p_slot->capture_seq;
+}
+
+// Called on DRP_FLG_FLIP
+static void record_latency(void) {
+    latency_stamp_t stamp;
+    uint32_t flip;
+
+    // flip_stamp may already hold the next frame
+    core_util_critical_section_enter();
+    stamp = shown_stamp;
+    flip  = flip_time;
+    histogram_add(&latency_hist[LATENCY_CAPTURE_START], stamp.start_time - stamp.capture_time);
+    histogram_add(&latency_hist[LATENCY_PROCESSING],    stamp.done_time - stamp.start_time);
+    histogram_add(&latency_hist[LATENCY_DISPLAY],       flip - stamp.done_time);
+    histogram_add(&latency_hist[LATENCY_TOTAL],         flip - stamp.capture_time);
+    core_util_critical_section_exit();
+
+    // Running average with a weight of 1/8
+    if (glass_latency == 0) {
+        glass_latency = flip - stamp.capture_time;
+    } else {
+        glass_latency += (int32_t)((flip - stamp.capture_time) - glass_latency) / 8;
+    }
+}
+
+//
+// Frames in flight
+// Every frame slot runs the stage list with its own intermediate buffers. DRP stages run on drpTask,
+// CPU stages on cpuTask, so stage k of a frame overlaps stage k-1 of the next frame when they use
+// different resources. A stage takes the frames in order, which keeps the temporal state and the
+// shared output buffer consistent.
+//
+static void remap_view(image_view_t * p_view, uint32_t slot) {
+    for (uint32_t i = 0; i < 2; i++) {
+        uint8_t * p_base = slot_work[0][i];
+
+        if ((p_view->base >= p_base) && (p_view->base < (p_base + FRAME_BUFFER_SIZE))) {
+            p_view->base = slot_work[slot][i] + (p_view->base - p_base);
+            return;
+        }
+    }
+}
+
+static void init_frame_slot(uint32_t drp_lib_num) {
+    for (uint32_t slot = 0; slot < FRAME_IN_FLIGHT_MAX; slot++) {
+        frame_slot_t * p_slot = &frame_slot[slot];
+
+        for (uint32_t i = 0; i < drp_lib_num; i++) {
+            p_slot->ctl[i] = drp_lib[i];
+            remap_view(&p_slot->ctl[i].src, slot);
+            remap_view(&p_slot->ctl[i].dst, slot);
+            remap_view(&p_slot->ctl[i].src_view, slot);
+            p_slot->ctl[i].p_param = &p_slot->param;
+        }
+        p_slot->active  = false;
+        for (uint32_t s = 0; s < STREAM_MAX; s++) {
+            p_slot->running[s] = false;
+        }
+    }
+    for (uint32_t i = 0; i < DRP_LIB_MAX; i++) {
+        stage_next_frame[i] = 0;
+    }
+    for (uint32_t s = 0; s < STREAM_MAX; s++) {
+        stream[s].drp_slot  = NULL;
+        stream[s].latency   = 0;
+        stream[s].period    = 0;
+        stream[s].frames    = 0;
+        stream[s].retry     = 0;
+        stream[s].last_done = exec_timer.read_us();
+    }
+    exec_latency   = 0;
+    exec_period    = 0;
+    glass_latency  = 0;
+    exec_last_done = exec_timer.read_us();
+}
+
+static frame_slot_t * get_free_slot(void) {
+    for (uint32_t slot = 0; slot < frame_depth; slot++) {
+        if (!frame_slot[slot].active) {
+            return &frame_slot[slot];
+        }
+    }
+    return NULL;
+}
+
+static bool is_frame_in_flight(void) {
+    for (uint32_t slot = 0; slot < frame_depth; slot++) {
+        if (frame_slot[slot].active) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void rewind_frame_slot(frame_slot_t * p_slot) {
+    for (uint32_t s = 0; s < STREAM_MAX; s++) {
+        p_slot->stage[s] = stream[s].first;
+    }
+    p_slot->skipped = false;
+}
+
+static bool is_frame_done(const frame_slot_t * p_slot) {
+    for (uint32_t s = 0; s < stream_num; s++) {
+        if (p_slot->stage[s] < stream[s].end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the oldest frame whose next stage of the stream runs on the given resource and may start now
+static frame_slot_t * get_ready_slot(uint32_t s, bool cpu) {
+    frame_slot_t * p_ready = NULL;
+
+    for (uint32_t slot = 0; slot < frame_depth; slot++) {
+        frame_slot_t * p_slot = &frame_slot[slot];
+        uint32_t stage = p_slot->stage[s];
+
+        if (!p_slot->active || p_slot->running[s] || (stage >= stream[s].end)) {
+            continue;
+        }
+        if ((is_cpu_stage(&p_slot->ctl[stage]) != cpu) || (stage_next_frame[stage] != p_slot->frame_no)) {
+            continue;
+        }
+        if ((p_ready == NULL) || ((int32_t)(p_slot->frame_no - p_ready->frame_no) < 0)) {
+            p_ready = p_slot;
+        }
+    }
+    return p_ready;
+}
+
+// Called when the last stage of a stream has finished
+static void finish_stream(frame_slot_t * p_slot, uint32_t s) {
+    stream_t * p_stream = &stream[s];
+    uint32_t now = exec_timer.read_us();
+
+    p_stream->latency += (int32_t)((now - p_slot->start_time) - p_stream->latency) / 8;
+    p_stream->period  += (int32_t)((now - p_stream->last_done) - p_stream->period) / 8;
+    p_stream->last_done = now;
+    p_stream->frames++;
+
+    // The output of the stream is read by the video engine
+    view_device_begin(&p_slot->ctl[p_stream->end - 1].dst, BUFFER_READ);
+    view_device_end(&p_slot->ctl[p_stream->end - 1].dst, BUFFER_READ);
+}
+
+static void finish_batch_frame(const frame_slot_t * p_slot);
+
+static void finish_frame(frame_slot_t * p_slot, uint32_t drp_lib_num) {
+    uint32_t now = exec_timer.read_us();
+
+    finish_batch_frame(p_slot);
+
+    // A skipped frame is released without taking part in the statistics
+    if (p_slot->skipped) {
+        p_slot->active = false;
+        return;
+    }
+
+    // Running averages with a weight of 1/8
+    exec_latency += (int32_t)((now - p_slot->start_time) - exec_latency) / 8;
+    exec_period  += (int32_t)((now - exec_last_done) - exec_period) / 8;
+    exec_last_done = now;
+
+    if (blob_labeling_mode) {
+        start_blob_labeling(&p_slot->ctl[drp_lib_num - 1].dst);
+    }
+
+    // The result is on the LCD from the next vsync. A frame replaced before that is not shown.
+    if (p_slot->capture_seq != 0) {
+        core_util_critical_section_enter();
+        if (flip_pending) {
+            latency_replaced++;
+        }
+        flip_stamp.capture_seq  = p_slot->capture_seq;
+        flip_stamp.capture_time = p_slot->capture_time;
+        flip_stamp.start_time   = p_slot->start_time;
+        flip_stamp.done_time    = now;
+        flip_pending = true;
+        core_util_critical_section_exit();
+    }
+
+    record_memory_access(p_slot, drp_lib_num);
+    memcpy(done_drp_lib, p_slot->ctl, sizeof(drp_lib_ctl_t) * drp_lib_num);
+    done_draw_req = true;
+
+    p_slot->active = false;
+}
+
+static void draw_frame_result(uint32_t drp_lib_num) {
+    if (done_draw_req) {
+        done_draw_req = false;
+        draw_processing_time(done_drp_lib, drp_lib_num);
+        draw_pipeline_time(drp_lib_num + 1);
+        draw_cache_maintenance(drp_lib_num + 2);
+        if (stream_num > 1) {
+            draw_stream_time(drp_lib_num + 3);
+        }
+        draw_stall(drp_lib_num + 3 + stream_num);
+    }
+}
+
+static void finish_stage(frame_slot_t * p_slot, uint32_t s, uint32_t drp_lib_num) {
+    p_slot->running[s] = false;
+    stage_next_frame[p_slot->stage[s]]++;
+    p_slot->stage[s]++;
+    if (p_slot->stage[s] >= stream[s].end) {
+        finish_stream(p_slot, s);
+        if (is_frame_done(p_slot)) {
+            finish_frame(p_slot, drp_lib_num);
+        }
+    }
+}
+
+static void prepare_stage(frame_slot_t * p_slot, uint32_t s, uint32_t drp_lib_num) {
+    // The labeling of the previous frame must finish before its input is overwritten
+    if (blob_busy && image_view_overlaps(&p_slot->ctl[p_slot->stage[s]].dst, &blob_view)) {
+        wait_blob_labeling(drp_lib_num + 3);
+    }
+    p_slot->ctl[p_slot->stage[s]].timeout_us = get_stage_timeout(p_slot->stage[s], stream[s].retry);
+    p_slot->running[s] = true;
+}
+
+// Called once the DRP stage of the stream has completed
+static void finish_drp_stage(frame_slot_t * p_slot, uint32_t s, uint32_t drp_lib_num) {
+    drp_lib_ctl_t * p_ctl = &p_slot->ctl[p_slot->stage[s]];
+
+    finish_drp_func(p_ctl, s);
+    update_stage_envelope(p_slot->stage[s], p_ctl->run_time);
+    stream[s].retry = 0;
+    finish_stage(p_slot, s, drp_lib_num);
+}
+
+// Drops the remaining stages of the stream for the frame. The frames behind it keep their order.
+static void skip_stream(frame_slot_t * p_slot, uint32_t s, uint32_t drp_lib_num) {
+    p_slot->running[s] = false;
+    p_slot->skipped    = true;
+    while (p_slot->stage[s] < stream[s].end) {
+        stage_next_frame[p_slot->stage[s]]++;
+        p_slot->stage[s]++;
+    }
+    if (is_frame_done(p_slot)) {
+        finish_frame(p_slot, drp_lib_num);
+    }
+}
+
+// Called when the DRP stage of the stream is late or a wait inside it has timed out.
+// The stage runs again from its start, or the frame is skipped after DRP_STALL_RETRY_MAX stalls.
+static void recover_drp_stage(frame_slot_t * p_slot, uint32_t s, uint32_t drp_lib_num) {
+    drp_lib_ctl_t * p_ctl = &p_slot->ctl[p_slot->stage[s]];
+    stall_event_t * p_event = &stall_log[stall_count % DRP_STALL_LOG_NUM];
+    bool skip = (stream[s].retry >= DRP_STALL_RETRY_MAX);
+
+    recover_drp_func(p_ctl, s);
+    p_event->time       = exec_timer.read_us();
+    p_event->frame_no   = p_slot->frame_no;
+    p_event->drp_lib_no = p_ctl->drp_lib_no;
+    p_event->tiles      = p_ctl->tiles;
+    p_event->waited     = p_ctl->run_time - p_ctl->pack_time;
+    p_event->timeout    = p_ctl->timeout_us;
+    p_event->skipped    = skip;
+    stall_count++;
+
+    if (skip) {
+        stall_skipped++;
+        stream[s].retry = 0;
+        skip_stream(p_slot, s, drp_lib_num);
+    } else {
+        stream[s].retry++;
+        p_slot->running[s] = false;
+    }
+}
+
+static void cpu_task(void) {
+    cpu_timer.start();
+
+    while (true) {
+        ThisThread::flags_wait_all(CPU_FLG_START);
+        run_cpu_func(&cpu_job->ctl[cpu_job->stage[cpu_stream]]);
+        drpTask.flags_set(DRP_FLG_CPU_DONE);
+    }
+}
+
+//
+// Headless batch
+// Frames are read from the storage instead of the camera and go through the frame slots like camera
+// frames, without waiting for the display. A file is read as soon as a slot and its input buffer
+// are free, and the result of each frame is written to a file when the frame finishes.
+//
+#define BATCH_MOUNT_NAME       "storage"
+#define BATCH_IN_PATH          "/" BATCH_MOUNT_NAME "/batch/in/%04u.pgm"
+#define BATCH_OUT_DIR          "/" BATCH_MOUNT_NAME "/batch/out"
+#define BATCH_OUT_PATH         BATCH_OUT_DIR "/%04u.pgm"
+#define BATCH_FRAME_MAX        (10000)
+
+static SdUsbConnect storage(BATCH_MOUNT_NAME);
+static volatile bool batch_req = false;
+static volatile bool batch_stop_req = false;
+static bool batch_gray = false;     // true: grayscale input, Bayer2Grayscale (stage 0) is skipped. Fixed while a batch runs.
+static volatile bool batch_run = false;  // Frames come from the storage, the camera is stopped
+static bool batch_end = false;      // No more file is read, the batch ends once the frames in flight have drained
+static uint32_t batch_frames;       // Results written
+static uint32_t batch_io_time;      // us spent in the file accesses
+static Timer batch_timer;
+
+// The streams of a mode work on bands of the frame, one below the other in the same buffer.
+// Joins the src (or dst) views of the first (or last) stage of every stream into the whole frame.
+static bool get_batch_view(const frame_slot_t * p_slot, bool last, bool dst, image_view_t * p_view) {
+    for (uint32_t s = 0; s < stream_num; s++) {
+        const drp_lib_ctl_t * p_ctl = &p_slot->ctl[last ? (stream[s].end - 1) : stream[s].first];
+        const image_view_t * p_band = dst ? &p_ctl->dst : &p_ctl->src;
+
+        if (s == 0) {
+            *p_view = *p_band;
+        } else if ((p_band->base == image_view_row(p_view, p_view->height)) &&
+                   (p_band->width == p_view->width) && (p_band->stride == p_view->stride)) {
+            p_view->height += p_band->height;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Grayscale frames are read into the output of Bayer2Grayscale
+static void get_batch_in_view(const frame_slot_t * p_slot, image_view_t * p_view) {
+    (void)get_batch_view(p_slot, false, batch_gray, p_view);
+}
+
+// The input buffer of a slot may be shared with the other slot (fbuf_bayer). It is free once
+// no stage left to the frames in flight reads or writes it.
+static bool is_batch_input_free(const frame_slot_t * p_free) {
+    image_view_t in_view;
+
+    get_batch_in_view(p_free, &in_view);
+    for (uint32_t slot = 0; slot < frame_depth; slot++) {
+        const frame_slot_t * p_slot = &frame_slot[slot];
+
+        if (!p_slot->active) {
+            continue;
+        }
+        for (uint32_t s = 0; s < stream_num; s++) {
+            for (uint32_t i = p_slot->stage[s]; i < stream[s].end; i++) {
+                const drp_lib_ctl_t * p_ctl = &p_slot->ctl[i];
+
+                if (image_view_overlaps(&p_ctl->src, &in_view) || image_view_overlaps(&p_ctl->dst, &in_view) ||
+                    ((p_ctl->src_view.base != NULL) && image_view_overlaps(&p_ctl->src_view, &in_view))) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Returns false when the mode cannot run on the files or there is no storage
+static bool begin_batch(void) {
+    image_view_t view;
+
+    for (uint32_t slot = 0; slot < frame_depth; slot++) {
+        const frame_slot_t * p_slot = &frame_slot[slot];
+
+        for (uint32_t s = 0; s < stream_num; s++) {
+            if (batch_gray && (p_slot->ctl[stream[s].first].drp_lib_no != DRP_LIB_BAYER2GRAYSCALE)) {
+                printf("batch: the mode does not start with Bayer2Grayscale\r\n");
+                return false;
+            }
+        }
+        if (!get_batch_view(p_slot, false, batch_gray, &view) || !get_batch_view(p_slot, true, true, &view)) {
+            printf("batch: the streams of the mode do not share one frame\r\n");
+            return false;
+        }
+    }
+    if (storage.connect() == SdUsbConnect::STORAGE_NON) {
+        printf("batch: no storage\r\n");
+        return false;
+    }
+    mkdir(BATCH_OUT_DIR, 0777);
+
+    // The camera stops writing fbuf_bayer
+    Display.Video_Stop(DisplayBase::VIDEO_INPUT_CHANNEL_0);
+    buffer_device_end(fbuf_bayer, sizeof(fbuf_bayer), BUFFER_WRITE);
+
+    batch_end      = false;
+    batch_frames   = 0;
+    batch_io_time  = 0;
+    batch_run      = true;
+    batch_timer.reset();
+    batch_timer.start();
+    return true;
+}
+
+// Reads file frame_no into the slot. Returns false at the end of the files.
+static bool start_batch_frame(frame_slot_t * p_slot, uint32_t frame_no) {
+    image_view_t in_view;
+    char path[48];
+    uint32_t io_start = batch_timer.read_us();
+    bool result = false;
+
+    get_batch_in_view(p_slot, &in_view);
+    if (frame_no < BATCH_FRAME_MAX) {
+        sprintf(path, BATCH_IN_PATH, (unsigned int)frame_no);
+        view_cpu_begin(&in_view, BUFFER_WRITE);
+        result = pgm_read(path, &in_view);
+        view_cpu_end(&in_view, BUFFER_WRITE);
+    }
+    batch_io_time += batch_timer.read_us() - io_start;
+    if (!result) {
+        return false;
+    }
+
+    p_slot->frame_no   = frame_no;
+    rewind_frame_slot(p_slot);
+    param_store_latch(&p_slot->param);
+    for (uint32_t s = 0; (s < stream_num) && batch_gray; s++) {
+        stage_next_frame[p_slot->stage[s]]++;
+        p_slot->stage[s]++;
+    }
+    p_slot->start_time  = exec_timer.read_us();
+    p_slot->capture_seq = 0;
+    p_slot->active      = true;
+    return true;
+}
+
+// Called from finish_frame, writes the result of the frame
+static void finish_batch_frame(const frame_slot_t * p_slot) {
+    image_view_t out_view;
+    char path[48];
+    uint32_t io_start;
+    bool result;
+
+    if (!batch_run) {
+        return;
+    }
+    if (p_slot->skipped) {
+        printf("batch: frame %u skipped after a DRP stall\r\n", (unsigned int)p_slot->frame_no);
+    }
+
+    io_start = batch_timer.read_us();
+    (void)get_batch_view(p_slot, true, true, &out_view);
+    sprintf(path, BATCH_OUT_PATH, (unsigned int)p_slot->frame_no);
+    view_cpu_begin(&out_view, BUFFER_READ);
+    result = pgm_write(path, &out_view);
+    view_cpu_end(&out_view, BUFFER_READ);
+    batch_io_time += batch_timer.read_us() - io_start;
+    if (result) {
+        batch_frames++;
+    } else {
+        printf("batch: %s write error\r\n", path);
+        batch_end = true;
+    }
+}
+
+// Called once the frames in flight have drained after the last file
+static void end_batch(uint32_t drp_lib_num) {
+    uint32_t total_time = batch_timer.read_us();
+
+    batch_timer.stop();
+    batch_run = false;
+    wait_blob_labeling(drp_lib_num + 3);
+
+    buffer_device_begin(fbuf_bayer, sizeof(fbuf_bayer), BUFFER_WRITE);
+    Display.Video_Start(DisplayBase::VIDEO_INPUT_CHANNEL_0);
+
+    // Frames per second in 0.1 units, with and without the file accesses
+    if ((batch_frames != 0) && (total_time > batch_io_time)) {
+        uint32_t fps    = (uint32_t)(((uint64_t)batch_frames * 10000000) / total_time);
+        uint32_t fps_io = (uint32_t)(((uint64_t)batch_frames * 10000000) / (total_time - batch_io_time));
+
+        printf("batch: %u frames in %u ms, %u.%u fps (%u.%u fps without file access)%s\r\n",
+               (unsigned int)batch_frames, (unsigned int)(total_time / 1000),
+               (unsigned int)(fps / 10), (unsigned int)(fps % 10), (unsigned int)(fps_io / 10), (unsigned int)(fps_io % 10),
+               batch_stop_req ? ", stopped" : "");
+    } else {
+        printf("batch: no frame in " BATCH_IN_PATH "\r\n", 0u);
+    }
+    batch_stop_req = false;
+}
+
+//
+// Serial console
+// One command per line.
+//
+#define CONSOLE_LINE_MAX       (64)
+
+typedef struct {
+    const char * name;
+    const char * help;
+    void (*p_func)(char * p_arg);
+} console_cmd_t;
+
+static void cmd_help(char * p_arg);
+
+static const char * get_trace_name(uint32_t drp_lib_no) {
+    return drp_lib_func_tbl[drp_lib_no].lib_name;
+}
+
+static void cmd_trace(char * p_arg) {
+    (void)p_arg;
+#if DRP_TRACE_ENABLE
+    drp_trace_dump(&get_trace_name);
+#else
+    printf("DRP trace is disabled (drp-trace in mbed_app.json)\r\n");
+#endif
+}
+
+static void cmd_mem(char * p_arg) {
+    (void)p_arg;
+#if RAM_TABLE_DYNAMIC_LOADING
+    config_memory_stats_t stats;
+
+    config_memory_get_stats(&stats);
+    printf("arena     %7u bytes\r\n", (unsigned int)stats.arena_size);
+    printf("used      %7u bytes (cached %u)\r\n", (unsigned int)stats.used_size, (unsigned int)stats.cached_size);
+    printf("high      %7u bytes\r\n", (unsigned int)stats.high_water);
+    printf("largest   %7u bytes free (fragmentation %u%%)\r\n", (unsigned int)stats.largest_free,
+           (unsigned int)stats.fragmentation);
+    printf("entries   %7u\r\n", (unsigned int)stats.entry_num);
+    printf("copied    %7u bytes (hit %u, compaction %u, eviction %u)\r\n", (unsigned int)stats.copy_bytes,
+           (unsigned int)stats.hit, (unsigned int)stats.compaction, (unsigned int)stats.eviction);
+#else
+    printf("The configuration data is used from ROM (RAM_TABLE_DYNAMIC_LOADING)\r\n");
+#endif
+}
+
+static void cmd_tier(char * p_arg) {
+    (void)p_arg;
+    uint32_t mode = mem_cur_mode;
+
+    printf("tier      capacity      used  bandwidth\r\n");
+    for (uint32_t i = 0; i < MEM_TIER_NUM; i++) {
+        if (mem_tier[i].size != 0) {
+            printf("%-8s %9u %9u %5u B/us\r\n", mem_tier[i].name, (unsigned int)mem_tier[i].size,
+                   (unsigned int)mem_tier[i].used, (unsigned int)mem_tier[i].bandwidth);
+        }
+    }
+    printf("item                  size  bytes/frame tier\r\n");
+    for (uint32_t i = 0; i < MEM_ITEM_NUM; i++) {
+        if (mem_item[i].tier != MEMORY_TIER_NONE) {
+            printf("%-18s %7u %12u %s\r\n", mem_item[i].name, (unsigned int)mem_item[i].size,
+                   (unsigned int)mem_item[i].access, mem_tier[mem_item[i].tier].name);
+        }
+    }
+    if (mode > DRP_MODE_MAX) {
+        return;
+    }
+    // The gain of the current placement over the one of the previous visit
+    printf("mode %u predicted %d us/frame (%u -> %u)\r\n", (unsigned int)mode,
+           (int)(mem_mode[mode].predict_prev - mem_mode[mode].predict),
+           (unsigned int)mem_mode[mode].predict_prev, (unsigned int)mem_mode[mode].predict);
+    if (mem_mode[mode].latency_prev != 0) {
+        printf("mode %u measured  %d us/frame (%u -> %u)\r\n", (unsigned int)mode,
+               (int)(mem_mode[mode].latency_prev - exec_latency),
+               (unsigned int)mem_mode[mode].latency_prev, (unsigned int)exec_latency);
+    }
+}
+
+static void cmd_batch(char * p_arg) {
+    unsigned int mode;
+
+    // The frames in flight finish and their results are written
+    if ((p_arg != NULL) && (strcmp(p_arg, "stop") == 0)) {
+        batch_req = false;
+        batch_stop_req = true;
+        return;
+    }
+    if ((p_arg == NULL) || (sscanf(p_arg, "%u", &mode) != 1) || (mode > DRP_MODE_MAX)) {
+        printf("usage: batch <mode> [gray] | batch stop\r\n");
+        return;
+    }
+    // batch_req is cleared only once batch_run is set, one of them is true until the batch ends
+    if (batch_req || batch_run) {
+        printf("batch: already running, type batch stop first\r\n");
+        return;
+    }
+    batch_gray = (strstr(p_arg, "gray") != NULL);
+    batch_stop_req = false;
+    mode_req = mode;
+    batch_req = true;
+}
+
+static void cmd_latency(char * p_arg) {
+    static const char * const name[LATENCY_NUM] = {"capture->start", "processing", "done->display", "glass-to-glass"};
+    histogram_t hist;
+
+    for (uint32_t i = 0; i < LATENCY_NUM; i++) {
+        core_util_critical_section_enter();
+        hist = latency_hist[i];
+        core_util_critical_section_exit();
+        histogram_print(&hist, name[i]);
+    }
+    printf("dropped fields %u, replaced frames %u\r\n", (unsigned int)latency_dropped, (unsigned int)latency_replaced);
+    if ((p_arg != NULL) && (strcmp(p_arg, "reset") == 0)) {
+        core_util_critical_section_enter();
+        init_latency();
+        core_util_critical_section_exit();
+    }
+}
+
+static void cmd_stream(char * p_arg) {
+    (void)p_arg;
+    for (uint32_t s = 0; s < stream_num; s++) {
+        const stream_t * p_stream = &stream[s];
+        uint32_t fps = (p_stream->period != 0) ? ((10000000 + (p_stream->period / 2)) / p_stream->period) : 0;  // 0.1fps unit
+
+        printf("stream %u: stages %u-%u, tiles 0x%02x, %u frames, %u.%u fps, latency %u us\r\n", (unsigned int)s,
+               (unsigned int)p_stream->first, (unsigned int)(p_stream->end - 1), (unsigned int)p_stream->tiles,
+               (unsigned int)p_stream->frames, (unsigned int)(fps / 10), (unsigned int)(fps % 10),
+               (unsigned int)p_stream->latency);
+    }
+}
+
+// The values of one command are checked first and published together at the next frame
+static void cmd_set(char * p_arg) {
+    uint32_t id[PARAM_NUM];
+    int32_t value[PARAM_NUM];
+    uint32_t num = 0;
+
+    if (p_arg == NULL) {
+        param_store_print();
+        return;
+    }
+    for (char * p_name = strtok(p_arg, " "); p_name != NULL; p_name = strtok(NULL, " ")) {
+        char * p_value = strtok(NULL, " ");
+        char * p_end;
+        int32_t i = param_store_find(p_name);
+
+        if ((i < 0) || (p_value == NULL) || (num >= PARAM_NUM)) {
+            printf("usage: set [<name> <value> ...]\r\n");
+            return;
+        }
+        id[num]    = (uint32_t)i;
+        value[num] = (int32_t)strtol(p_value, &p_end, 0);
+        if (*p_end != '\0') {
+            printf("%s: %s is not a number\r\n", p_name, p_value);
+            return;
+        }
+        if (!param_store_is_valid(id[num], value[num])) {
+            printf("%s: %d is out of range\r\n", p_name, (int)value[num]);
+            return;
+        }
+        num++;
+    }
+    param_store_begin();
+    for (uint32_t i = 0; i < num; i++) {
+        (void)param_store_set(id[i], value[i]);
+    }
+    param_store_end();
+}
+
+// Frames in flight per mode. The current mode is set up again for a new depth once its frames have drained.
+static void cmd_depth(char * p_arg) {
+    unsigned int mode;
+    unsigned int depth;
+
+    if (p_arg == NULL) {
+        printf("%u frames in flight (1-%u)\r\n", (unsigned int)frame_depth, (unsigned int)FRAME_IN_FLIGHT_MAX);
+        for (uint32_t i = 0; i <= DRP_MODE_MAX; i++) {
+            if (depth_req[i] != 0) {
+                printf("mode %u: set to %u\r\n", (unsigned int)i, (unsigned int)depth_req[i]);
+            }
+        }
+        return;
+    }
+    if ((sscanf(p_arg, "%u %u", &mode, &depth) != 2) || (mode > DRP_MODE_MAX) || (depth > FRAME_IN_FLIGHT_MAX)) {
+        printf("usage: depth [<mode> <1-%u, 0: default>]\r\n", (unsigned int)FRAME_IN_FLIGHT_MAX);
+        return;
+    }
+    depth_req[mode] = depth;
+    if (mode == mode_req) {
+        mode_reload_req = true;
+    }
+}
+
+// The last DRP_STALL_LOG_NUM stalls, oldest first
+static void cmd_stall(char * p_arg) {
+    uint32_t count = stall_count;
+    uint32_t top = (count > DRP_STALL_LOG_NUM) ? (count - DRP_STALL_LOG_NUM) : 0;
+
+    (void)p_arg;
+    printf("%u stalls, %u frames skipped\r\n", (unsigned int)count, (unsigned int)stall_skipped);
+    for (uint32_t i = top; i < count; i++) {
+        const stall_event_t * p_event = &stall_log[i % DRP_STALL_LOG_NUM];
+
+        printf("  %10u us frame %u: %s tiles 0x%02x, %u us (limit %u us), %s\r\n", (unsigned int)p_event->time,
+               (unsigned int)p_event->frame_no, drp_lib_func_tbl[p_event->drp_lib_no].lib_name,
+               (unsigned int)p_event->tiles, (unsigned int)p_event->waited, (unsigned int)p_event->timeout,
+               p_event->skipped ? "skipped" : "retried");
+    }
+    for (uint32_t i = 0; i < stream[stream_num - 1].end; i++) {
+        if (!is_cpu_stage(&drp_lib[i])) {
+            printf("stage %u: %s limit %u us\r\n", (unsigned int)i, drp_lib_func_tbl[drp_lib[i].drp_lib_no].lib_name,
+                   (unsigned int)get_stage_timeout(i, 0));
+        }
+    }
+}
+
+static const console_cmd_t console_cmd_tbl[] = {
+//   name      help
+    {"help",  "List the commands",                           &cmd_help},
+    {"trace", "Dump the DRP trace as Chrome trace JSON",     &cmd_trace},
+    {"mem",   "Show the configuration memory usage",         &cmd_mem},
+    {"tier",  "Show the memory tier placement and its gain",     &cmd_tier},
+    {"batch", "Run a mode on batch/in/*.pgm of the storage, or stop",  &cmd_batch},
+    {"latency", "Show the latency histograms ([reset])",       &cmd_latency},
+    {"stream", "Show the frame rate and latency of each stream", &cmd_stream},
+    {"set",   "Show or set the stage parameters ([<name> <value> ...])", &cmd_set},
+    {"stall", "Show the DRP stalls and the stage deadlines",  &cmd_stall},
+    {"depth", "Show or set the frames in flight of a mode ([<mode> <n>])", &cmd_depth},
+};
+
+static void cmd_help(char * p_arg) {
+    (void)p_arg;
+    for (uint32_t i = 0; i < (sizeof(console_cmd_tbl) / sizeof(console_cmd_t)); i++) {
+        printf("%-8s: %s\r\n", console_cmd_tbl[i].name, console_cmd_tbl[i].help);
+    }
+}
+
+static void console_exec(char * p_line) {
+    char * p_arg = strchr(p_line, ' ');
+
+    if (p_arg != NULL) {
+        *p_arg++ = '\0';
+    }
+    if (p_line[0] == '\0') {
+        return;
+    }
+    for (uint32_t i = 0; i < (sizeof(console_cmd_tbl) / sizeof(console_cmd_t)); i++) {
+        if (strcmp(p_line, console_cmd_tbl[i].name) == 0) {
+            console_cmd_tbl[i].p_func(p_arg);
+            return;
+        }
+    }
+    printf("Unknown command: %s\r\n", p_line);
+}
+
+static void console_task(void) {
+    char line[CONSOLE_LINE_MAX];
+    uint32_t len = 0;
+
+    while (true) {
+        int c = getchar();
+
+        if ((c == '\r') || (c == '\n')) {
+            line[len] = '\0';
+            console_exec(line);
+            len = 0;
+        } else if ((c >= ' ') && (len < (CONSOLE_LINE_MAX - 1))) {
+            line[len++] = c;
+        }
+    }
+}
+
 //
 // DRP task processing
 //
 static void drp_task(void) {
     uint32_t mode = 0xffffffff;
     uint32_t drp_lib_num = 0;
+    uint32_t frame_no = 0;
 
     button.fall(&button_fall);
 
+    exec_timer.start();
     EasyAttach_Init(Display);
     Start_LCD_Display();
     // Interrupt callback function setting (Field end signal for recording function in scaler 0)
     Display.Graphics_Irq_Handler_Set(DisplayBase::INT_TYPE_S0_VFIELD, 0, IntCallbackFunc_Vfield);
+    // LCD vsync, the result drawn before it is scanned out from here
+    Display.Graphics_Irq_Handler_Set(DisplayBase::INT_TYPE_S0_LO_VSYNC, 0, IntCallbackFunc_LoVsync);
+    init_latency();
+    param_store_init(param_def_tbl, PARAM_NUM);
+    init_memory_tier();
+    init_buffer_owner();
     Start_Video_Camera();
 
     R_DK2_Initialize();
+    drp_job_init();
+    drp_trace_init();
 
     t.start();
     event_time.start();
 
     while (true) {
+        frame_slot_t * p_slot;
+        drp_lib_ctl_t * p_ctl;
+        uint32_t flags;
+        bool progress = false;
+
         // Check event timer
-        if (event_time.read_ms() >= 10000) {
+        if (!batch_req && !batch_run && (event_time.read_ms() >= 10000)) {
             button_fall();
         }
 
-        // Check mode change
-        if (mode_req != mode) {
+        // Check mode change (once the frames in flight have drained, a batch runs to its end)
+        if (((mode_req != mode) || mode_reload_req) && !batch_run && !is_frame_in_flight()) {
+            mode_reload_req = false;
+            wait_blob_labeling(drp_lib_num + 3);
             mode = mode_req;
-            drp_lib_num = init_drp_lib(mode);
+            if (place_memory(mode)) {
+                drp_lib_num = init_drp_lib(mode);
+                cur_envelope = stage_envelope[mode];
+            } else {
+                skip_drp_lib(mode);
+                drp_lib_num = 0;
+            }
+            init_frame_slot(drp_lib_num);
+            frame_no = 0;
+            if (drp_lib_num == 0) {
+                batch_req = false;
+                button_fall();
+            }
         }
 
-        // Waiting for camera image
-        ThisThread::flags_wait_all(DRP_FLG_CAMER_IN);
+        // Headless batch requested from the console, once the frames in flight have drained
+        if (batch_req && !batch_run && (mode_req == mode) && !is_frame_in_flight()) {
+            init_frame_slot(drp_lib_num);
+            frame_no = 0;
+            if (!begin_batch()) {
+                event_time.reset();
+            }
+            batch_req = false;
+        }
+        if (batch_run && (batch_end || batch_stop_req) && !is_frame_in_flight()) {
+            end_batch(drp_lib_num);
+            init_frame_slot(drp_lib_num);
+            frame_no = 0;
+            event_time.reset();
+            ThisThread::flags_clear(DRP_FLG_CAMER_IN);
+        }
 
-        // DRP execution
-        drp_lib_ctl_t * p_drp_lib = &drp_lib[0];
-        for (uint32_t i = 0; i < drp_lib_num; i++) {
-            drp_lib_func_tbl[p_drp_lib->drp_lib_no].p_func(p_drp_lib);
-            p_drp_lib++;
+        flags = ThisThread::flags_get();
+        if ((flags & DRP_FLG_FLIP) != 0) {
+            ThisThread::flags_clear(DRP_FLG_FLIP);
+            record_latency();
+        }
+        if ((flags & DRP_FLG_CPU_DONE) != 0) {
+            ThisThread::flags_clear(DRP_FLG_CPU_DONE);
+            p_slot = cpu_job;
+            cpu_job = NULL;
+            finish_stage(p_slot, cpu_stream, drp_lib_num);
+            progress = true;
+        }
+
+        // Collect the DRP stages that have finished
+        for (uint32_t s = 0; s < stream_num; s++) {
+            p_slot = stream[s].drp_slot;
+            if (p_slot == NULL) {
+                continue;
+            }
+            ThisThread::flags_clear(stream[s].job_flg);
+            p_ctl = &p_slot->ctl[p_slot->stage[s]];
+            if (!p_ctl->stalled && drp_job_poll(&p_ctl->job)) {
+                stream[s].drp_slot = NULL;
+                finish_drp_stage(p_slot, s, drp_lib_num);
+                progress = true;
+            } else if (p_ctl->stalled || is_stage_late(p_ctl)) {
+                stream[s].drp_slot = NULL;
+                recover_drp_stage(p_slot, s, drp_lib_num);
+                progress = true;
+            }
+        }
+
+        // Start a frame for the next file of the batch
+        if (batch_run && !batch_end && !batch_stop_req && ((p_slot = get_free_slot()) != NULL) && is_batch_input_free(p_slot)) {
+            if (start_batch_frame(p_slot, frame_no)) {
+                frame_no++;
+            } else {
+                batch_end = true;
+            }
+            progress = true;
         }
 
-        // Draw processing time
-        draw_processing_time(drp_lib_num);
+        // Start a frame for the latest camera image
+        if ((mode_req == mode) && !batch_req && !batch_run && ((flags & DRP_FLG_CAMER_IN) != 0) && ((p_slot = get_free_slot()) != NULL)) {
+            ThisThread::flags_clear(DRP_FLG_CAMER_IN);
+            p_slot->frame_no   = frame_no++;
+            rewind_frame_slot(p_slot);
+            param_store_latch(&p_slot->param);
+            p_slot->start_time = exec_timer.read_us();
+            p_slot->active     = true;
+            stamp_frame(p_slot);
+            progress = true;
+        }
+
+        // Hand a CPU stage over to cpuTask
+        for (uint32_t s = 0; (s < stream_num) && (cpu_job == NULL); s++) {
+            if ((p_slot = get_ready_slot(s, true)) != NULL) {
+                prepare_stage(p_slot, s, drp_lib_num);
+                cpu_stream = s;
+                cpu_job = p_slot;
+                cpuTask.flags_set(CPU_FLG_START);
+                progress = true;
+            }
+        }
+
+        // DRP execution on every tile group that is free, the thread goes on while the last phase of the stage runs
+        for (uint32_t s = 0; s < stream_num; s++) {
+            if ((stream[s].drp_slot != NULL) || ((drp_job_free_tiles() & stream[s].tiles) != stream[s].tiles)) {
+                continue;
+            }
+            if ((p_slot = get_ready_slot(s, false)) != NULL) {
+                p_ctl = &p_slot->ctl[p_slot->stage[s]];
+                prepare_stage(p_slot, s, drp_lib_num);
+                start_drp_func(p_ctl, s);
+                drp_job_notify(&p_ctl->job, &drpTask, stream[s].job_flg);
+                stream[s].drp_slot = p_slot;
+                progress = true;
+            }
+        }
+
+        // Overlay drawing overlaps the DRP
+        draw_frame_result(drp_lib_num);
+
+        // Nothing to do until a stage finishes or, with a free slot, the next camera image arrives.
+        // A running DRP stage bounds the wait by its deadline.
+        if (!progress) {
+            uint32_t wait_flg = DRP_FLG_CPU_DONE | DRP_FLG_FLIP;
+            uint32_t wait_ms = osWaitForever;
+
+            for (uint32_t s = 0; s < stream_num; s++) {
+                p_slot = stream[s].drp_slot;
+                if (p_slot != NULL) {
+                    uint32_t ms = get_stage_wait_ms(&p_slot->ctl[p_slot->stage[s]]);
+
+                    wait_flg |= stream[s].job_flg;
+                    wait_ms = (ms < wait_ms) ? ms : wait_ms;
+                }
+            }
+            if ((mode_req == mode) && (get_free_slot() != NULL)) {
+                wait_flg |= DRP_FLG_CAMER_IN;
+            }
+            if (wait_ms == osWaitForever) {
+                ThisThread::flags_wait_any(wait_flg, false);
+            } else {
+                ThisThread::flags_wait_any_for(wait_flg, wait_ms, false);
+            }
+        }
     }
 }
 
 int main(void) {
     // Start DRP task
     drpTask.start(callback(drp_task));
+    blobTask.start(callback(blob_task));
+    cpuTask.start(callback(cpu_task));
+    consoleTask.start(callback(console_task));
 
     wait(osWaitForever);
 }
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Converts frame sequences for the headless batch mode.
+
+split: cuts a raw 8-bit sequence file (Bayer or grayscale, frames stored
+       back to back) into DIR/0000.pgm, DIR/0001.pgm, ... The file is
+       memory-mapped, so sequences larger than the host memory work too.
+join:  concatenates DIR/0000.pgm, ... (e.g. batch/out copied from the
+       card) back into one raw sequence file.
+
+Copy the split frames to batch/in on the SD card, then type
+"batch <mode> [gray]" on the serial console.
+
+usage: batch_frames.py split RAW DIR [-W 640] [-H 480]
+       batch_frames.py join DIR RAW
+"""
+
+import argparse
+import mmap
+import os
+import sys
+
+
+def split(args):
+    frame_size = args.width * args.height
+    os.makedirs(args.dir, exist_ok=True)
+    with open(args.raw, "rb") as f:
+        with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as m:
+            frame_num = len(m) // frame_size
+            for no in range(frame_num):
+                with open(os.path.join(args.dir, "%04d.pgm" % no), "wb") as out:
+                    out.write(b"P5\n%d %d\n255\n" % (args.width, args.height))
+                    out.write(m[no * frame_size:(no + 1) * frame_size])
+    print("%d frames written to %s" % (frame_num, args.dir))
+    return 0
+
+
+def read_pgm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    fields = data.split(maxsplit=4)
+    if fields[0] != b"P5":
+        raise ValueError("%s is not a binary PGM" % path)
+    width, height = int(fields[1]), int(fields[2])
+    return data[len(data) - (width * height):]
+
+
+def join(args):
+    no = 0
+    with open(args.raw, "wb") as out:
+        while os.path.exists(os.path.join(args.dir, "%04d.pgm" % no)):
+            out.write(read_pgm(os.path.join(args.dir, "%04d.pgm" % no)))
+            no += 1
+    print("%d frames written to %s" % (no, args.raw))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command")
+    p = sub.add_parser("split", help="raw sequence to PGM files")
+    p.add_argument("raw")
+    p.add_argument("dir")
+    p.add_argument("-W", "--width", type=int, default=640)
+    p.add_argument("-H", "--height", type=int, default=480)
+    p = sub.add_parser("join", help="PGM files to raw sequence")
+    p.add_argument("dir")
+    p.add_argument("raw")
+    args = parser.parse_args()
+
+    if args.command == "split":
+        return split(args)
+    if args.command == "join":
+        return join(args)
+    parser.print_help()
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""Extracts DRP traces from a captured serial log.
+
+Every block printed by the console command "trace" between
+---DRP TRACE BEGIN--- and ---DRP TRACE END--- is written to its own
+Chrome trace-event file, which can be opened with chrome://tracing or
+https://ui.perfetto.dev. A per-tile utilization summary is printed for
+each trace.
+
+usage: drp_trace.py LOG [-o PREFIX]
+"""
+
+import argparse
+import json
+import sys
+
+BEGIN_MARK = "---DRP TRACE BEGIN---"
+END_MARK = "---DRP TRACE END---"
+TILE_NUM = 6
+
+
+def extract_blocks(lines):
+    block = None
+    for line in lines:
+        line = line.strip()
+        if line == BEGIN_MARK:
+            block = []
+        elif line == END_MARK:
+            if block is not None:
+                yield "".join(block)
+            block = None
+        elif block is not None:
+            block.append(line)
+
+
+def print_summary(trace):
+    events = [e for e in trace["traceEvents"] if e.get("ph") == "X"]
+    if not events:
+        print("  no events")
+        return
+    span_top = min(e["ts"] for e in events)
+    span_end = max(e["ts"] + e["dur"] for e in events)
+    span = max(span_end - span_top, 1)
+    print("  span %.1f ms" % (span / 1000.0))
+
+    for tile in range(TILE_NUM):
+        busy = {}
+        for e in events:
+            if e["tid"] == tile:
+                name = e["name"].strip()
+                busy[name] = busy.get(name, 0) + e["dur"]
+        total = sum(busy.values())
+        detail = ", ".join("%s %.1f%%" % (name, 100.0 * dur / span) for name, dur in sorted(busy.items()))
+        print("  tile %d: busy %5.1f%%  %s" % (tile, 100.0 * total / span, detail))
+
+    load = sum(e["dur"] for e in events if e["name"] in ("Load", "Activate"))
+    print("  load/activate %5.1f%%" % (100.0 * load / span))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", help="serial log captured while the trace command ran")
+    parser.add_argument("-o", "--output", default="drp_trace", help="output file prefix (default: drp_trace)")
+    args = parser.parse_args()
+
+    with open(args.log, "r", errors="replace") as f:
+        blocks = list(extract_blocks(f))
+    if not blocks:
+        print("no DRP trace found in %s" % args.log, file=sys.stderr)
+        return 1
+
+    for no, block in enumerate(blocks):
+        try:
+            trace = json.loads(block)
+        except ValueError as e:
+            print("trace %d is broken: %s" % (no, e), file=sys.stderr)
+            continue
+        name = "%s_%d.json" % (args.output, no)
+        with open(name, "w") as f:
+            json.dump(trace, f)
+        print("%s:" % name)
+        print_summary(trace)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,325 @@
+#include "mbed.h"
+#include "blob_labeling.h"
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BLOB_USE_NEON          (1)
+#endif
+
+#define SLOT_NONE              (0xFFFF)
+
+typedef struct {
+    uint16_t x0;            // First pixel of the run
+    uint16_t x1;            // Last pixel of the run (inclusive)
+    uint16_t y;
+    uint16_t reserved;
+} blob_run_t;
+
+typedef struct {
+    uint32_t top;           // Runs [top, top + run_num) of run_pool belong to the stripe
+    uint32_t run_num;
+    uint32_t first_row_end; // Runs [top, first_row_end) belong to the first row of the stripe
+    uint32_t last_row_top;  // Runs [last_row_top, top + run_num) belong to the last row of the stripe
+    bool     overflow;
+} blob_stripe_t;
+
+typedef struct {
+    uint32_t area;
+    uint16_t x_min;
+    uint16_t y_min;
+    uint16_t x_max;
+    uint16_t y_max;
+    uint32_t sx;
+    uint32_t sy;
+    uint64_t sxx;
+    uint64_t syy;
+    uint64_t sxy;
+} blob_acc_t;
+
+static const uint8_t * p_src_img;
+static uint32_t src_width;
+static uint32_t src_height;
+static uint32_t src_stride;
+
+// Shared by the stripes, each one takes its runs from run_cursor on
+static blob_run_t run_pool[BLOB_RUN_MAX];
+static uint32_t run_cursor;
+static uint16_t run_parent[BLOB_RUN_MAX];
+static uint16_t root_slot[BLOB_RUN_MAX];
+static blob_stripe_t stripe_info[BLOB_STRIPE_NUM];
+static blob_acc_t blob_acc[BLOB_LABEL_MAX];
+
+//
+// Run extraction
+//
+static inline bool block_is_clear(const uint8_t * p) {
+#if BLOB_USE_NEON
+    uint8x16_t v = vld1q_u8(p);
+    uint8x8_t  r = vorr_u8(vget_low_u8(v), vget_high_u8(v));
+    return (vget_lane_u64(vreinterpret_u64_u8(r), 0) == 0);
+#else
+    uint32_t w[4];
+    memcpy(w, p, sizeof(w));
+    return ((w[0] | w[1] | w[2] | w[3]) == 0);
+#endif
+}
+
+static inline bool block_is_filled(const uint8_t * p) {
+#if BLOB_USE_NEON
+    uint8x16_t v = vceqq_u8(vld1q_u8(p), vdupq_n_u8(0));
+    uint8x8_t  r = vorr_u8(vget_low_u8(v), vget_high_u8(v));
+    return (vget_lane_u64(vreinterpret_u64_u8(r), 0) == 0);
+#else
+    for (uint32_t i = 0; i < 16; i++) {
+        if (p[i] == 0) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+static uint32_t extract_runs(const uint8_t * p_row, uint32_t y, blob_run_t * p_run, uint32_t run_max, bool * p_overflow) {
+    uint32_t run_num = 0;
+    uint32_t x = 0;
+
+    while (x < src_width) {
+        // Skip the background, 16 pixels at a time where possible
+        while (((x + 16) <= src_width) && block_is_clear(&p_row[x])) {
+            x += 16;
+        }
+        while ((x < src_width) && (p_row[x] == 0)) {
+            x++;
+        }
+        if (x >= src_width) {
+            break;
+        }
+
+        uint32_t x0 = x;
+
+        while (((x + 16) <= src_width) && block_is_filled(&p_row[x])) {
+            x += 16;
+        }
+        while ((x < src_width) && (p_row[x] != 0)) {
+            x++;
+        }
+
+        if (run_num >= run_max) {
+            *p_overflow = true;
+            break;
+        }
+        p_run[run_num].x0 = x0;
+        p_run[run_num].x1 = x - 1;
+        p_run[run_num].y  = y;
+        run_num++;
+    }
+
+    return run_num;
+}
+
+//
+// Union-find over run indices
+//
+static uint32_t find_root(uint32_t idx) {
+    while (run_parent[idx] != idx) {
+        run_parent[idx] = run_parent[run_parent[idx]];
+        idx = run_parent[idx];
+    }
+    return idx;
+}
+
+static void unite(uint32_t a, uint32_t b) {
+    a = find_root(a);
+    b = find_root(b);
+    if (a < b) {
+        run_parent[b] = a;
+    } else if (b < a) {
+        run_parent[a] = b;
+    }
+}
+
+// Unites 8-connected runs of two adjacent rows
+static void connect_rows(uint32_t prev_top, uint32_t prev_end, uint32_t cur_top, uint32_t cur_end) {
+    uint32_t prev = prev_top;
+
+    for (uint32_t cur = cur_top; cur < cur_end; cur++) {
+        while ((prev < prev_end) && ((run_pool[prev].x1 + 1) < run_pool[cur].x0)) {
+            prev++;
+        }
+        for (uint32_t idx = prev; (idx < prev_end) && (run_pool[idx].x0 <= (run_pool[cur].x1 + 1)); idx++) {
+            unite(idx, cur);
+        }
+    }
+}
+
+//
+// Feature accumulation
+//
+static void accumulate_run(blob_acc_t * p_acc, const blob_run_t * p_run) {
+    uint32_t n  = p_run->x1 - p_run->x0 + 1;
+    uint32_t y  = p_run->y;
+    uint32_t sx = ((p_run->x0 + p_run->x1) * n) / 2;
+    uint64_t s2_end = ((uint64_t)p_run->x1 * (p_run->x1 + 1) * (2 * p_run->x1 + 1)) / 6;
+    uint64_t s2_top = (p_run->x0 == 0) ? 0 : (((uint64_t)(p_run->x0 - 1) * p_run->x0 * (2 * p_run->x0 - 1)) / 6);
+
+    if (p_acc->area == 0) {
+        p_acc->x_min = p_run->x0;
+        p_acc->x_max = p_run->x1;
+        p_acc->y_min = y;
+        p_acc->y_max = y;
+    } else {
+        if (p_run->x0 < p_acc->x_min) {
+            p_acc->x_min = p_run->x0;
+        }
+        if (p_run->x1 > p_acc->x_max) {
+            p_acc->x_max = p_run->x1;
+        }
+        if (y < p_acc->y_min) {
+            p_acc->y_min = y;
+        }
+        if (y > p_acc->y_max) {
+            p_acc->y_max = y;
+        }
+    }
+    p_acc->area += n;
+    p_acc->sx   += sx;
+    p_acc->sy   += y * n;
+    p_acc->sxx  += s2_end - s2_top;
+    p_acc->syy  += (uint64_t)y * y * n;
+    p_acc->sxy  += (uint64_t)y * sx;
+}
+
+static void make_feature(blob_feature_t * p_feature, const blob_acc_t * p_acc) {
+    float area = (float)p_acc->area;
+    float cx = (float)p_acc->sx / area;
+    float cy = (float)p_acc->sy / area;
+
+    p_feature->area  = p_acc->area;
+    p_feature->x_min = p_acc->x_min;
+    p_feature->y_min = p_acc->y_min;
+    p_feature->x_max = p_acc->x_max;
+    p_feature->y_max = p_acc->y_max;
+    p_feature->cx    = cx;
+    p_feature->cy    = cy;
+    p_feature->mu20  = ((float)p_acc->sxx / area) - (cx * cx);
+    p_feature->mu02  = ((float)p_acc->syy / area) - (cy * cy);
+    p_feature->mu11  = ((float)p_acc->sxy / area) - (cx * cy);
+}
+
+//
+// Public functions
+//
+void blob_labeling_begin(const uint8_t * p_img, uint32_t width, uint32_t height, uint32_t stride) {
+    p_src_img  = p_img;
+    src_width  = width;
+    src_height = height;
+    src_stride = stride;
+    memset(stripe_info, 0, sizeof(stripe_info));
+    run_cursor = 0;
+}
+
+void blob_labeling_stripe(uint32_t stripe_no) {
+    blob_stripe_t * p_stripe = &stripe_info[stripe_no];
+    uint32_t stripe_height = src_height / BLOB_STRIPE_NUM;
+    uint32_t y_top = stripe_height * stripe_no;
+    uint32_t y_end = (stripe_no == (BLOB_STRIPE_NUM - 1)) ? src_height : (y_top + stripe_height);
+    uint32_t top = run_cursor;
+    uint32_t prev_top = top;
+    uint32_t prev_end = top;
+    uint32_t cur_end = top;
+
+    for (uint32_t y = y_top; y < y_end; y++) {
+        uint32_t cur_top = cur_end;
+        uint32_t run_num = extract_runs(&p_src_img[src_stride * y], y, &run_pool[cur_top],
+                                        BLOB_RUN_MAX - cur_top, &p_stripe->overflow);
+
+        cur_end = cur_top + run_num;
+        for (uint32_t idx = cur_top; idx < cur_end; idx++) {
+            run_parent[idx] = idx;
+        }
+        if (y == y_top) {
+            p_stripe->first_row_end = cur_end;
+        } else {
+            connect_rows(prev_top, prev_end, cur_top, cur_end);
+        }
+        prev_top = cur_top;
+        prev_end = cur_end;
+        if (p_stripe->overflow) {
+            break;
+        }
+    }
+    p_stripe->last_row_top = prev_top;
+    p_stripe->top = top;
+    p_stripe->run_num = cur_end - top;
+    run_cursor = cur_end;
+}
+
+void blob_labeling_end(uint32_t min_area, blob_result_t * p_result) {
+    uint32_t slot_num = 0;
+    bool overflow = false;
+
+    // Merge labels across the stripe seams
+    for (uint32_t stripe_no = 1; stripe_no < BLOB_STRIPE_NUM; stripe_no++) {
+        blob_stripe_t * p_upper = &stripe_info[stripe_no - 1];
+        blob_stripe_t * p_lower = &stripe_info[stripe_no];
+        if (p_upper->overflow) {
+            continue;  // The last row of the upper stripe was not reached
+        }
+        connect_rows(p_upper->last_row_top, p_upper->top + p_upper->run_num, p_lower->top, p_lower->first_row_end);
+    }
+
+    // Accumulate the features per root
+    for (uint32_t stripe_no = 0; stripe_no < BLOB_STRIPE_NUM; stripe_no++) {
+        uint32_t top = stripe_info[stripe_no].top;
+        uint32_t end = top + stripe_info[stripe_no].run_num;
+
+        overflow |= stripe_info[stripe_no].overflow;
+        for (uint32_t idx = top; idx < end; idx++) {
+            root_slot[idx] = SLOT_NONE;
+        }
+    }
+    for (uint32_t stripe_no = 0; stripe_no < BLOB_STRIPE_NUM; stripe_no++) {
+        uint32_t top = stripe_info[stripe_no].top;
+        uint32_t end = top + stripe_info[stripe_no].run_num;
+
+        for (uint32_t idx = top; idx < end; idx++) {
+            uint32_t root = find_root(idx);
+
+            if (root_slot[root] == SLOT_NONE) {
+                if (slot_num >= BLOB_LABEL_MAX) {
+                    overflow = true;
+                    continue;
+                }
+                memset(&blob_acc[slot_num], 0, sizeof(blob_acc_t));
+                root_slot[root] = slot_num++;
+            }
+            accumulate_run(&blob_acc[root_slot[root]], &run_pool[idx]);
+        }
+    }
+
+    // Emit the feature list
+    p_result->blob_num = 0;
+    p_result->feature_num = 0;
+    p_result->run_num = 0;
+    p_result->overflow = overflow;
+    for (uint32_t stripe_no = 0; stripe_no < BLOB_STRIPE_NUM; stripe_no++) {
+        p_result->run_num += stripe_info[stripe_no].run_num;
+    }
+    for (uint32_t slot = 0; slot < slot_num; slot++) {
+        if (blob_acc[slot].area < min_area) {
+            continue;
+        }
+        p_result->blob_num++;
+        if (p_result->feature_num < BLOB_FEATURE_MAX) {
+            make_feature(&p_result->feature[p_result->feature_num++], &blob_acc[slot]);
+        }
+    }
+}
+
+void blob_labeling(const uint8_t * p_img, uint32_t width, uint32_t height, uint32_t stride,
+                   uint32_t min_area, blob_result_t * p_result) {
+    blob_labeling_begin(p_img, width, height, stride);
+    for (uint32_t stripe_no = 0; stripe_no < BLOB_STRIPE_NUM; stripe_no++) {
+        blob_labeling_stripe(stripe_no);
+    }
+    blob_labeling_end(min_area, p_result);
+}
@@ -0,0 +1,50 @@
+#ifndef BLOB_LABELING_H
+#define BLOB_LABELING_H
+
+#include <stdint.h>
+
+/*! The image is labeled in horizontal stripes that match the DRP tile partition.
+    Each stripe can be labeled as soon as its rows are available, and labels are
+    merged across the stripe seams afterwards. The stripes share one pool of
+    BLOB_RUN_MAX runs, so a busy stripe may take more than its share. */
+#define BLOB_STRIPE_NUM        (6)
+#define BLOB_RUN_MAX           (6 * 2048)
+#define BLOB_LABEL_MAX         (1024)
+#define BLOB_FEATURE_MAX       (128)
+
+typedef struct {
+    uint32_t area;          // m00
+    uint16_t x_min;         // Bounding box (inclusive)
+    uint16_t y_min;
+    uint16_t x_max;
+    uint16_t y_max;
+    float    cx;            // Centroid
+    float    cy;
+    float    mu20;          // Central second moments normalized by area
+    float    mu02;
+    float    mu11;
+} blob_feature_t;
+
+typedef struct {
+    uint32_t blob_num;      // Number of blobs at or above min_area
+    uint32_t feature_num;   // Number of entries stored in feature[]
+    uint32_t run_num;       // Number of foreground runs
+    bool     overflow;      // Run or label capacity was exceeded, results are partial
+    blob_feature_t feature[BLOB_FEATURE_MAX];
+} blob_result_t;
+
+/* Prepares labeling of a binary image (non-zero pixels are foreground). */
+extern void blob_labeling_begin(const uint8_t * p_img, uint32_t width, uint32_t height, uint32_t stride);
+
+/* Labels one stripe. Stripes are independent of each other and may be processed in any order,
+   from one thread. */
+extern void blob_labeling_stripe(uint32_t stripe_no);
+
+/* Merges labels across stripe seams and extracts the features of the blobs of min_area pixels or more. */
+extern void blob_labeling_end(uint32_t min_area, blob_result_t * p_result);
+
+/* Runs all of the above on the whole image. */
+extern void blob_labeling(const uint8_t * p_img, uint32_t width, uint32_t height, uint32_t stride,
+                          uint32_t min_area, blob_result_t * p_result);
+
+#endif
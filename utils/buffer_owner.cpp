@@ -0,0 +1,189 @@
+#include "mbed.h"
+#include "dcache-control.h"
+#include "buffer_owner.h"
+
+#define CHUNK_DEVICE           (0x01)   // A device may have written it, lines in the CPU cache are stale
+#define CHUNK_DIRTY            (0x02)   // The CPU may hold dirty lines
+#define CHUNK_HELD_CPU         (0x04)   // Debug: between buffer_cpu_begin and buffer_cpu_end
+#define CHUNK_HELD_DEVICE      (0x08)   // Debug: written by a device between begin and end
+
+typedef struct {
+    uint8_t * p_base;
+    uint32_t  size;
+    uint8_t * p_chunk;      // State per chunk (NULL for a non-cacheable or an untracked buffer)
+    bool      cached;
+} buffer_region_t;
+
+static buffer_region_t region[BUFFER_OWNER_REGION_MAX];
+static uint32_t region_num = 0;
+static uint8_t chunk_state[BUFFER_OWNER_CHUNK_MAX];
+static uint32_t chunk_used = 0;
+static buffer_owner_stats_t stats;
+static Mutex owner_mutex;
+
+bool buffer_owner_register(void * p_base, uint32_t size, bool cached) {
+    uint32_t chunk_num = (size + BUFFER_OWNER_CHUNK - 1) / BUFFER_OWNER_CHUNK;
+    buffer_region_t * p_region;
+    bool tracked = true;
+
+    owner_mutex.lock();
+    if (region_num >= BUFFER_OWNER_REGION_MAX) {
+        owner_mutex.unlock();
+        return false;
+    }
+    p_region = &region[region_num++];
+    p_region->p_base  = (uint8_t *)p_base;
+    p_region->size    = size;
+    p_region->p_chunk = NULL;
+    p_region->cached  = cached;
+    if (cached) {
+        if ((chunk_used + chunk_num) <= BUFFER_OWNER_CHUNK_MAX) {
+            p_region->p_chunk = &chunk_state[chunk_used];
+            chunk_used += chunk_num;
+            memset(p_region->p_chunk, CHUNK_DIRTY, chunk_num);
+        } else {
+            tracked = false;
+        }
+    }
+    owner_mutex.unlock();
+
+    return tracked;
+}
+
+static buffer_region_t * find_region(const uint8_t * p_addr, uint32_t size) {
+    for (uint32_t i = 0; i < region_num; i++) {
+        buffer_region_t * p_region = &region[i];
+
+        if ((p_addr >= p_region->p_base) && ((p_addr + size) <= (p_region->p_base + p_region->size))) {
+            return p_region;
+        }
+    }
+#if BUFFER_OWNER_DEBUG
+    printf("buffer_owner: %p (%u bytes) is not registered\r\n", p_addr, (unsigned int)size);
+    stats.violation++;
+#endif
+    return NULL;
+}
+
+static void report(const buffer_region_t * p_region, uint32_t chunk, const char * p_msg) {
+#if BUFFER_OWNER_DEBUG
+    printf("buffer_owner: %p %s\r\n", p_region->p_base + (chunk * BUFFER_OWNER_CHUNK), p_msg);
+    stats.violation++;
+#else
+    (void)p_region;
+    (void)chunk;
+    (void)p_msg;
+#endif
+}
+
+// Maintains a run of consecutive chunks with one call
+static void maintain(const buffer_region_t * p_region, uint32_t top, uint32_t end, bool clean) {
+    uint8_t * p_buf = p_region->p_base + (top * BUFFER_OWNER_CHUNK);
+    uint32_t size = (end - top) * BUFFER_OWNER_CHUNK;
+
+    if ((p_buf + size) > (p_region->p_base + p_region->size)) {
+        size = (p_region->p_base + p_region->size) - p_buf;
+    }
+    if (clean) {
+        dcache_clean(p_buf, size);
+        stats.clean_bytes += size;
+    } else {
+        dcache_invalidate(p_buf, size);
+        stats.invalidate_bytes += size;
+    }
+}
+
+// Runs maintenance on the chunks of [p_addr, p_addr + size) that have the "need" bit,
+// then applies set/clear to every chunk of the range
+static void transition(const void * p_addr, uint32_t size, uint8_t need, bool clean, uint8_t set, uint8_t clear,
+                       uint8_t conflict, const char * p_msg) {
+    const uint8_t * p_top = (const uint8_t *)p_addr;
+    buffer_region_t * p_region;
+    uint32_t top;
+    uint32_t end;
+    uint32_t run_top = 0;
+    bool run = false;
+
+    if (size == 0) {
+        return;
+    }
+    owner_mutex.lock();
+    p_region = find_region(p_top, size);
+    if ((p_region == NULL) || !p_region->cached) {
+        owner_mutex.unlock();
+        return;
+    }
+    top = (p_top - p_region->p_base) / BUFFER_OWNER_CHUNK;
+    end = ((p_top - p_region->p_base) + size + BUFFER_OWNER_CHUNK - 1) / BUFFER_OWNER_CHUNK;
+
+    // An untracked buffer is maintained in full. Dirty lines around the range are cleaned before an invalidate.
+    if (p_region->p_chunk == NULL) {
+        if (need != 0) {
+            if (!clean) {
+                maintain(p_region, top, end, true);
+            }
+            maintain(p_region, top, end, clean);
+        }
+        owner_mutex.unlock();
+        return;
+    }
+    for (uint32_t chunk = top; chunk < end; chunk++) {
+        uint8_t state = p_region->p_chunk[chunk];
+
+        if ((state & conflict) != 0) {
+            report(p_region, chunk, p_msg);
+        }
+        if ((state & need) != 0) {
+            if (!run) {
+                run_top = chunk;
+                run = true;
+            }
+        } else if (run) {
+            maintain(p_region, run_top, chunk, clean);
+            run = false;
+        }
+        p_region->p_chunk[chunk] = (state & ~clear) | set;
+    }
+    if (run) {
+        maintain(p_region, run_top, end, clean);
+    }
+    owner_mutex.unlock();
+}
+
+void buffer_cpu_begin(const void * p_addr, uint32_t size, uint32_t access) {
+    (void)access;
+    // Stale lines are dropped whether the CPU reads or writes: a partial write would merge with them
+    transition(p_addr, size, CHUNK_DEVICE, false, BUFFER_OWNER_DEBUG ? CHUNK_HELD_CPU : 0, CHUNK_DEVICE,
+               CHUNK_HELD_DEVICE, "CPU access while a device writes");
+}
+
+void buffer_cpu_end(const void * p_addr, uint32_t size, uint32_t access) {
+    transition(p_addr, size, 0, false, ((access & BUFFER_WRITE) != 0) ? CHUNK_DIRTY : 0, CHUNK_HELD_CPU,
+               0, NULL);
+}
+
+void buffer_device_begin(const void * p_addr, uint32_t size, uint32_t access) {
+    uint8_t set = 0;
+
+    if ((access & BUFFER_WRITE) != 0) {
+        set = CHUNK_DEVICE | (BUFFER_OWNER_DEBUG ? CHUNK_HELD_DEVICE : 0);
+    }
+    transition(p_addr, size, CHUNK_DIRTY, true, set, CHUNK_DIRTY,
+               ((access & BUFFER_WRITE) != 0) ? CHUNK_HELD_CPU : 0, "device write while the CPU accesses");
+}
+
+void buffer_device_end(const void * p_addr, uint32_t size, uint32_t access) {
+    if ((access & BUFFER_WRITE) != 0) {
+        transition(p_addr, size, 0, false, 0, CHUNK_HELD_DEVICE, 0, NULL);
+    }
+}
+
+void buffer_owner_get_stats(buffer_owner_stats_t * p_stats, bool reset) {
+    owner_mutex.lock();
+    *p_stats = stats;
+    if (reset) {
+        stats.clean_bytes = 0;
+        stats.invalidate_bytes = 0;
+    }
+    owner_mutex.unlock();
+}
@@ -0,0 +1,47 @@
+#ifndef BUFFER_OWNER_H
+#define BUFFER_OWNER_H
+
+#include <stdint.h>
+
+/*! Tracks which side last wrote each chunk of the registered buffers, the CPU
+    (through the data cache) or a bus master such as the DRP or the video
+    engine, and performs cache maintenance only on the chunks that cross from
+    one side to the other:
+      - the CPU touches a chunk a device has written  -> invalidate
+      - a device touches a chunk the CPU has written  -> clean
+    Every access is bracketed by a begin/end pair. Buffers in non-cacheable
+    memory are registered with cached = false and never maintained. */
+
+#ifndef BUFFER_OWNER_DEBUG
+#define BUFFER_OWNER_DEBUG      (0)     /* 1: Report accesses outside the registered buffers and overlapping owners */
+#endif
+
+#define BUFFER_OWNER_CHUNK      (1024)  /* Tracking granularity in bytes, a multiple of the cache line */
+#define BUFFER_OWNER_REGION_MAX (16)
+#define BUFFER_OWNER_CHUNK_MAX  (8192)
+
+#define BUFFER_READ             (0x1)
+#define BUFFER_WRITE            (0x2)
+#define BUFFER_READ_WRITE       (BUFFER_READ | BUFFER_WRITE)
+
+typedef struct {
+    uint32_t clean_bytes;
+    uint32_t invalidate_bytes;
+    uint32_t violation;         /* Protocol errors found in debug mode */
+} buffer_owner_stats_t;
+
+/* Registers a buffer. p_base must be aligned to the cache line. Cached buffers start out
+   as possibly dirty in the CPU cache. Returns false when the chunk table is full, the buffer
+   is then maintained in full on every access, or when the region table is full, the buffer
+   is then not maintained at all. */
+extern bool buffer_owner_register(void * p_base, uint32_t size, bool cached);
+
+extern void buffer_cpu_begin(const void * p_addr, uint32_t size, uint32_t access);
+extern void buffer_cpu_end(const void * p_addr, uint32_t size, uint32_t access);
+extern void buffer_device_begin(const void * p_addr, uint32_t size, uint32_t access);
+extern void buffer_device_end(const void * p_addr, uint32_t size, uint32_t access);
+
+/* Returns the bytes maintained since the previous reset. */
+extern void buffer_owner_get_stats(buffer_owner_stats_t * p_stats, bool reset);
+
+#endif
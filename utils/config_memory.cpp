@@ -0,0 +1,211 @@
+#include "mbed.h"
+#include "buffer_owner.h"
+#include "config_memory.h"
+
+typedef struct {
+    const uint8_t * p_src;      // Library binary the entry is a copy of (NULL: unused entry)
+    uint8_t *       p_addr;
+    uint32_t        size;       // Rounded up to CONFIG_MEMORY_ALIGN
+    uint32_t        ref;
+    uint32_t        last_use;
+} config_entry_t;
+
+static uint8_t * arena_top;
+static uint32_t arena_size;
+static config_entry_t entry[CONFIG_ENTRY_MAX];
+static uint32_t use_count;
+static config_memory_stats_t stats;
+
+void config_memory_init(uint8_t * p_arena, uint32_t size) {
+    arena_top  = (uint8_t *)(((uint32_t)p_arena + (CONFIG_MEMORY_ALIGN - 1)) & ~(CONFIG_MEMORY_ALIGN - 1));
+    arena_size = (size - (arena_top - p_arena)) & ~(CONFIG_MEMORY_ALIGN - 1);
+    memset(entry, 0, sizeof(entry));
+    memset(&stats, 0, sizeof(stats));
+    use_count = 0;
+}
+
+// Indices of the used entries in address order
+static uint32_t get_sorted_entry(uint8_t * p_order) {
+    uint32_t num = 0;
+
+    for (uint32_t i = 0; i < CONFIG_ENTRY_MAX; i++) {
+        if (entry[i].p_src == NULL) {
+            continue;
+        }
+        uint32_t pos = num++;
+
+        while ((pos > 0) && (entry[p_order[pos - 1]].p_addr > entry[i].p_addr)) {
+            p_order[pos] = p_order[pos - 1];
+            pos--;
+        }
+        p_order[pos] = i;
+    }
+    return num;
+}
+
+// First fit. Also returns the free space and the largest free block.
+static uint8_t * find_free(uint32_t size, uint32_t * p_free, uint32_t * p_largest) {
+    uint8_t order[CONFIG_ENTRY_MAX];
+    uint32_t num = get_sorted_entry(order);
+    uint8_t * p_pos = arena_top;
+    uint8_t * p_fit = NULL;
+    uint32_t free_size = 0;
+    uint32_t largest = 0;
+
+    for (uint32_t i = 0; i <= num; i++) {
+        uint8_t * p_end = (i < num) ? entry[order[i]].p_addr : (arena_top + arena_size);
+        uint32_t gap = p_end - p_pos;
+
+        if ((p_fit == NULL) && (gap >= size)) {
+            p_fit = p_pos;
+        }
+        free_size += gap;
+        if (gap > largest) {
+            largest = gap;
+        }
+        if (i < num) {
+            p_pos = entry[order[i]].p_addr + entry[order[i]].size;
+        }
+    }
+    if (p_free != NULL) {
+        *p_free = free_size;
+    }
+    if (p_largest != NULL) {
+        *p_largest = largest;
+    }
+    return p_fit;
+}
+
+void config_memory_compact(void) {
+    uint8_t order[CONFIG_ENTRY_MAX];
+    uint32_t num = get_sorted_entry(order);
+    uint8_t * p_pos = arena_top;
+    bool moved = false;
+
+    for (uint32_t i = 0; i < num; i++) {
+        config_entry_t * p_entry = &entry[order[i]];
+
+        if (p_entry->p_addr != p_pos) {
+            buffer_cpu_begin(p_pos, (p_entry->p_addr + p_entry->size) - p_pos, BUFFER_READ_WRITE);
+            memmove(p_pos, p_entry->p_addr, p_entry->size);
+            buffer_cpu_end(p_pos, (p_entry->p_addr + p_entry->size) - p_pos, BUFFER_READ_WRITE);
+            p_entry->p_addr = p_pos;
+            moved = true;
+        }
+        p_pos += p_entry->size;
+    }
+    if (moved) {
+        stats.compaction++;
+    }
+}
+
+// Frees the cached entry used least recently
+static bool evict_cached(void) {
+    config_entry_t * p_victim = NULL;
+
+    for (uint32_t i = 0; i < CONFIG_ENTRY_MAX; i++) {
+        config_entry_t * p_entry = &entry[i];
+
+        if ((p_entry->p_src != NULL) && (p_entry->ref == 0) &&
+            ((p_victim == NULL) || ((int32_t)(p_entry->last_use - p_victim->last_use) < 0))) {
+            p_victim = p_entry;
+        }
+    }
+    if (p_victim == NULL) {
+        return false;
+    }
+    p_victim->p_src = NULL;
+    stats.eviction++;
+    return true;
+}
+
+config_handle_t config_memory_get(const uint8_t * p_bin, uint32_t size) {
+    uint32_t aligned_size = (size + (CONFIG_MEMORY_ALIGN - 1)) & ~(CONFIG_MEMORY_ALIGN - 1);
+    config_entry_t * p_entry = NULL;
+    uint8_t * p_addr;
+    uint32_t free_size;
+    uint32_t i;
+
+    // Shared entry
+    for (i = 0; i < CONFIG_ENTRY_MAX; i++) {
+        if ((entry[i].p_src == p_bin) && (entry[i].size == aligned_size)) {
+            entry[i].ref++;
+            entry[i].last_use = use_count++;
+            stats.hit++;
+            return i + 1;
+        }
+    }
+
+    while (true) {
+        for (i = 0; i < CONFIG_ENTRY_MAX; i++) {
+            if (entry[i].p_src == NULL) {
+                p_entry = &entry[i];
+                break;
+            }
+        }
+        p_addr = find_free(aligned_size, &free_size, NULL);
+        if ((p_addr == NULL) && (free_size >= aligned_size)) {
+            config_memory_compact();
+            p_addr = find_free(aligned_size, NULL, NULL);
+        }
+        if ((p_entry != NULL) && (p_addr != NULL)) {
+            break;
+        }
+        if (!evict_cached()) {
+            return CONFIG_HANDLE_NONE;
+        }
+        p_entry = NULL;
+    }
+
+    buffer_cpu_begin(p_addr, size, BUFFER_WRITE);
+    memcpy(p_addr, p_bin, size);
+    buffer_cpu_end(p_addr, size, BUFFER_WRITE);
+    stats.copy_bytes += size;
+
+    p_entry->p_src    = p_bin;
+    p_entry->p_addr   = p_addr;
+    p_entry->size     = aligned_size;
+    p_entry->ref      = 1;
+    p_entry->last_use = use_count++;
+    if ((uint32_t)((p_addr + aligned_size) - arena_top) > stats.high_water) {
+        stats.high_water = (p_addr + aligned_size) - arena_top;
+    }
+
+    return (p_entry - &entry[0]) + 1;
+}
+
+void config_memory_put(config_handle_t handle) {
+    if ((handle != CONFIG_HANDLE_NONE) && (entry[handle - 1].ref > 0)) {
+        entry[handle - 1].ref--;
+    }
+}
+
+uint8_t * config_memory_addr(config_handle_t handle) {
+    if (handle == CONFIG_HANDLE_NONE) {
+        return NULL;
+    }
+    return entry[handle - 1].p_addr;
+}
+
+void config_memory_get_stats(config_memory_stats_t * p_stats) {
+    uint32_t free_size;
+    uint32_t largest;
+
+    stats.arena_size  = arena_size;
+    stats.used_size   = 0;
+    stats.cached_size = 0;
+    stats.entry_num   = 0;
+    for (uint32_t i = 0; i < CONFIG_ENTRY_MAX; i++) {
+        if (entry[i].p_src != NULL) {
+            stats.used_size += entry[i].size;
+            if (entry[i].ref == 0) {
+                stats.cached_size += entry[i].size;
+            }
+            stats.entry_num++;
+        }
+    }
+    (void)find_free(0xFFFFFFFF, &free_size, &largest);
+    stats.largest_free  = largest;
+    stats.fragmentation = (free_size == 0) ? 0 : (100 - ((largest * 100) / free_size));
+    *p_stats = stats;
+}
@@ -0,0 +1,50 @@
+#ifndef CONFIG_MEMORY_H
+#define CONFIG_MEMORY_H
+
+#include <stdint.h>
+
+/*! Allocator for DRP configuration data copied to RAM.
+    Entries are shared per library binary and reference counted. An entry
+    whose count drops to zero stays cached, so a binary used by the next
+    mode again (Bayer2Grayscale in every mode) is not copied again; cached
+    entries are evicted, least recently used first, when space runs out.
+    Entries are referred to by handle because compaction moves them:
+    resolve the address with config_memory_addr() right before R_DK2_Load.
+    Allocation and compaction must happen while the DRP is not loading. */
+
+#define CONFIG_MEMORY_ALIGN     (32)
+#define CONFIG_ENTRY_MAX        (32)
+#define CONFIG_HANDLE_NONE      (0)
+
+typedef uint32_t config_handle_t;
+
+typedef struct {
+    uint32_t arena_size;
+    uint32_t used_size;         /* Referenced and cached entries */
+    uint32_t cached_size;       /* Entries with no reference */
+    uint32_t high_water;        /* Highest end offset ever allocated */
+    uint32_t largest_free;
+    uint32_t fragmentation;     /* % of the free space outside the largest free block */
+    uint32_t entry_num;
+    uint32_t copy_bytes;        /* Bytes copied since init */
+    uint32_t hit;               /* Requests served by an existing entry */
+    uint32_t compaction;
+    uint32_t eviction;
+} config_memory_stats_t;
+
+extern void config_memory_init(uint8_t * p_arena, uint32_t size);
+
+/* Returns a handle to a copy of p_bin, or CONFIG_HANDLE_NONE if it cannot fit. */
+extern config_handle_t config_memory_get(const uint8_t * p_bin, uint32_t size);
+
+/* Drops a reference. The entry is kept as a cache until the space is needed. */
+extern void config_memory_put(config_handle_t handle);
+
+extern uint8_t * config_memory_addr(config_handle_t handle);
+
+/* Moves the entries down to the start of the arena, closing the gaps. */
+extern void config_memory_compact(void);
+
+extern void config_memory_get_stats(config_memory_stats_t * p_stats);
+
+#endif
@@ -0,0 +1,204 @@
+#include "mbed.h"
+#include "r_dk2_if.h"
+#include "drp_job.h"
+#include "drp_trace.h"
+
+static EventFlags job_flags;    // One bit per tile, set when the circuit on the tile finishes
+static EventFlags tile_free;    // One bit per tile, set while no submitter holds the tile
+static Timer job_timer;
+static drp_job_t * running_job[DRP_JOB_MAX];
+static uint32_t load_count = 0;
+
+#define TILE_ALL               ((1u << R_DK2_TILE_NUM) - 1)
+
+void drp_job_init(void) {
+    tile_free.set(TILE_ALL);
+    job_timer.start();
+}
+
+void drp_job_lock(void) {
+    drp_job_lock_tiles(TILE_ALL);
+}
+
+void drp_job_unlock(void) {
+    drp_job_unlock_tiles(TILE_ALL);
+}
+
+void drp_job_lock_tiles(uint32_t tiles) {
+    // The flags are cleared together when all of them are set
+    tile_free.wait_all(tiles);
+}
+
+void drp_job_unlock_tiles(uint32_t tiles) {
+    tile_free.set(tiles);
+}
+
+uint32_t drp_job_free_tiles(void) {
+    return tile_free.get() & TILE_ALL;
+}
+
+int32_t drp_job_load(const void * p_config, uint8_t top_tiles, uint32_t tile_pat, load_cb_t p_load, int_cb_t p_int, uint8_t * p_aid) {
+    int32_t ret;
+
+    drp_trace(DRP_TRACE_LOAD_BEGIN, top_tiles, 0);
+    load_count++;
+    ret = R_DK2_Load(p_config, top_tiles, tile_pat, p_load, p_int, p_aid);
+    drp_trace(DRP_TRACE_LOAD_END, top_tiles, 0);
+
+    return ret;
+}
+
+uint32_t drp_job_load_count(void) {
+    return load_count;
+}
+
+int32_t drp_job_activate(uint8_t id, uint32_t freq) {
+    int32_t ret;
+
+    drp_trace(DRP_TRACE_ACTIVATE_BEGIN, 0, id);
+    ret = R_DK2_Activate(id, freq);
+    drp_trace(DRP_TRACE_ACTIVATE_END, 0, id);
+
+    return ret;
+}
+
+int32_t drp_job_start(drp_job_t * p_job, const uint8_t * p_lib_id, uint32_t tile_no, void * p_param, uint32_t size) {
+    uint32_t tiles = 0;
+
+    // Id 0 would take in every tile without a circuit, and the job would never complete
+    if (p_lib_id[tile_no] == 0) {
+        return DRP_JOB_ERR_NO_CIRCUIT;
+    }
+    for (uint32_t i = 0; i < R_DK2_TILE_NUM; i++) {
+        if (p_lib_id[i] == p_lib_id[tile_no]) {
+            tiles |= (1 << i);
+        }
+    }
+
+    core_util_critical_section_enter();
+    if (p_job->state != DRP_JOB_RUNNING) {
+        uint32_t i;
+
+        for (i = 0; i < DRP_JOB_MAX; i++) {
+            if (running_job[i] == NULL) {
+                running_job[i] = p_job;
+                break;
+            }
+        }
+        if (i >= DRP_JOB_MAX) {
+            core_util_critical_section_exit();
+            return DRP_JOB_ERR_FULL;
+        }
+        p_job->tiles    = 0;
+        p_job->state    = DRP_JOB_RUNNING;
+        p_job->finished = false;
+        p_job->p_then   = NULL;
+        p_job->p_notify = NULL;
+    }
+    p_job->tiles |= tiles;
+    p_job->finished = false;
+    job_flags.clear(tiles);
+    core_util_critical_section_exit();
+
+    drp_trace(DRP_TRACE_START, tiles, 0);
+    return R_DK2_Start(p_lib_id[tile_no], p_param, size);
+}
+
+void drp_job_finish_isr(uint32_t tiles) {
+    uint32_t flags = job_flags.set(tiles);
+
+    drp_trace(DRP_TRACE_FINISH, tiles, 0);
+
+    for (uint32_t i = 0; i < DRP_JOB_MAX; i++) {
+        drp_job_t * p_job = running_job[i];
+
+        if ((p_job != NULL) && !p_job->finished && ((flags & p_job->tiles) == p_job->tiles)) {
+            p_job->finished = true;
+            p_job->done_us  = job_timer.read_us();
+            if (p_job->p_notify != NULL) {
+                p_job->p_notify->flags_set(p_job->notify_flg);
+            }
+        }
+    }
+}
+
+static void complete_job(drp_job_t * p_job) {
+    drp_job_func_t p_func;
+
+    core_util_critical_section_enter();
+    for (uint32_t i = 0; i < DRP_JOB_MAX; i++) {
+        if (running_job[i] == p_job) {
+            running_job[i] = NULL;
+        }
+    }
+    p_job->state = DRP_JOB_DONE;
+    p_func = p_job->p_then;
+    p_job->p_then = NULL;
+    core_util_critical_section_exit();
+
+    if (p_func != NULL) {
+        p_func(p_job->p_arg);
+    }
+}
+
+bool drp_job_poll(drp_job_t * p_job) {
+    if (p_job->state != DRP_JOB_RUNNING) {
+        return true;
+    }
+    if (!p_job->finished) {
+        return false;
+    }
+    complete_job(p_job);
+    return true;
+}
+
+bool drp_job_wait(drp_job_t * p_job, uint32_t timeout_ms) {
+    if (p_job->state != DRP_JOB_RUNNING) {
+        return true;
+    }
+    if ((job_flags.wait_all(p_job->tiles, timeout_ms, false) & osFlagsError) != 0) {
+        return false;
+    }
+    complete_job(p_job);
+    return true;
+}
+
+void drp_job_abort(drp_job_t * p_job) {
+    core_util_critical_section_enter();
+    for (uint32_t i = 0; i < DRP_JOB_MAX; i++) {
+        if (running_job[i] == p_job) {
+            running_job[i] = NULL;
+        }
+    }
+    p_job->state    = DRP_JOB_IDLE;
+    p_job->finished = false;
+    p_job->p_then   = NULL;
+    p_job->p_notify = NULL;
+    core_util_critical_section_exit();
+}
+
+void drp_job_then(drp_job_t * p_job, drp_job_func_t p_func, void * p_arg) {
+    p_job->p_arg  = p_arg;
+    p_job->p_then = p_func;
+    if (p_job->state != DRP_JOB_RUNNING) {
+        p_job->done_us = job_timer.read_us();  // Nothing is outstanding, the job completes now
+        complete_job(p_job);
+    }
+}
+
+void drp_job_notify(drp_job_t * p_job, Thread * p_thread, uint32_t notify_flg) {
+    core_util_critical_section_enter();
+    p_job->p_notify   = p_thread;
+    p_job->notify_flg = notify_flg;
+    if ((p_job->state != DRP_JOB_RUNNING) || p_job->finished) {
+        p_thread->flags_set(notify_flg);
+    }
+    core_util_critical_section_exit();
+}
+
+uint32_t drp_job_idle_us(const drp_job_t * p_job) {
+    if ((p_job->state == DRP_JOB_IDLE) || ((p_job->state == DRP_JOB_RUNNING) && !p_job->finished)) {
+        return 0;
+    }
+    return job_timer.read_us() - p_job->done_us;
+}
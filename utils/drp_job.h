@@ -0,0 +1,90 @@
+#ifndef DRP_JOB_H
+#define DRP_JOB_H
+
+#include "mbed.h"
+#include "r_dk2_if.h"
+
+/*! Completion handles for DRP circuits started with R_DK2_Start.
+    The handle is a drp_job_t owned by the submitter (the stage control block in
+    main.cpp), passed to drp_job_start and then polled or waited for, so handles
+    need no pool and live as long as their stage. A job collects the tiles of the circuits started through it and completes
+    when all of them have finished. The completion is recorded from the DRP
+    callback into an EventFlags, so any thread can poll or wait for a job, and
+    a continuation can be chained to it. Continuations run in thread context,
+    in the thread that polls or waits for the job.
+    The tiles are arbitrated between submitters with drp_job_lock_tiles/
+    unlock_tiles, held from R_DK2_Load to R_DK2_Unload, so circuits on
+    disjoint tile groups run at the same time. drp_job_lock/unlock take the
+    whole array. */
+
+#define DRP_JOB_MAX            (8)     /* Jobs running at the same time */
+
+#define DRP_JOB_IDLE           (0)
+#define DRP_JOB_RUNNING        (1)
+#define DRP_JOB_DONE           (2)
+
+#define DRP_JOB_ERR_NO_CIRCUIT (-100)  /* drp_job_start on a tile without a circuit */
+#define DRP_JOB_ERR_FULL       (-101)  /* drp_job_start with DRP_JOB_MAX jobs already running */
+
+typedef void (*drp_job_func_t)(void * p_arg);
+
+typedef struct {
+    uint32_t       tiles;       /* Tiles started through the job */
+    uint32_t       state;
+    volatile bool  finished;    /* Set by the DRP callback once every tile has finished */
+    uint32_t       done_us;     /* Time of the completion */
+    drp_job_func_t p_then;
+    void *         p_arg;
+    Thread *       p_notify;
+    uint32_t       notify_flg;
+} drp_job_t;
+
+extern void drp_job_init(void);
+
+/* Takes and releases the DRP. The lock is not owned by a thread, a continuation may release it. */
+extern void drp_job_lock(void);
+extern void drp_job_unlock(void);
+
+/* Same for a group of tiles (bit n is tile n). Taking waits until all of them are free. */
+extern void drp_job_lock_tiles(uint32_t tiles);
+extern void drp_job_unlock_tiles(uint32_t tiles);
+
+/* Tiles not held by any submitter */
+extern uint32_t drp_job_free_tiles(void);
+
+/* R_DK2_Load and R_DK2_Activate, recorded in the DRP trace */
+extern int32_t drp_job_load(const void * p_config, uint8_t top_tiles, uint32_t tile_pat, load_cb_t p_load, int_cb_t p_int, uint8_t * p_aid);
+extern int32_t drp_job_activate(uint8_t id, uint32_t freq);
+
+/* Number of drp_job_load calls since start-up */
+extern uint32_t drp_job_load_count(void);
+
+/* Starts the circuit loaded on tile_no (R_DK2_Start). A finished job is reset first,
+   so consecutive starts on a running job add circuits to it. Returns the result of R_DK2_Start,
+   or without touching the job DRP_JOB_ERR_NO_CIRCUIT when no circuit is loaded on tile_no and
+   DRP_JOB_ERR_FULL when DRP_JOB_MAX other jobs are running. */
+extern int32_t drp_job_start(drp_job_t * p_job, const uint8_t * p_lib_id, uint32_t tile_no, void * p_param, uint32_t size);
+
+/* To be called from the DRP finish callback with the tiles of the finished circuit. */
+extern void drp_job_finish_isr(uint32_t tiles);
+
+/* Returns true once the job has completed, running its continuation the first time. */
+extern bool drp_job_poll(drp_job_t * p_job);
+
+/* Waits up to timeout_ms (osWaitForever for no limit). Returns false on timeout. */
+extern bool drp_job_wait(drp_job_t * p_job, uint32_t timeout_ms);
+
+/* Abandons a job whose completion is not coming (stalled circuit, lost callback). It leaves the
+   running jobs without running its continuation or notifying. The circuits stay loaded. */
+extern void drp_job_abort(drp_job_t * p_job);
+
+/* Chains a continuation. It runs at once if the job has already completed or nothing was started. */
+extern void drp_job_then(drp_job_t * p_job, drp_job_func_t p_func, void * p_arg);
+
+/* Sets notify_flg on a thread when the job completes, so the thread can sleep on its own flags. */
+extern void drp_job_notify(drp_job_t * p_job, Thread * p_thread, uint32_t notify_flg);
+
+/* Time between the completion and now, i.e. how long the result waited to be collected. */
+extern uint32_t drp_job_idle_us(const drp_job_t * p_job);
+
+#endif
@@ -0,0 +1,176 @@
+#include "mbed.h"
+#include "r_dk2_if.h"
+#include "drp_trace.h"
+
+#if DRP_TRACE_ENABLE
+
+#define TRACK_LOADER           (R_DK2_TILE_NUM)         // tid of Load / Activate
+#define TRACK_STAGE            (R_DK2_TILE_NUM + 1)     // tid of the stages, one per track
+
+typedef struct {
+    uint32_t time_us;
+    uint8_t  type;
+    uint8_t  tiles;
+    uint16_t arg;
+} drp_trace_event_t;
+
+static drp_trace_event_t trace_ring[DRP_TRACE_EVENT_MAX];
+static uint32_t trace_pos = 0;          // Total number of events written
+static volatile bool trace_frozen = false;
+static Timer trace_timer;
+
+void drp_trace_init(void) {
+    trace_timer.start();
+}
+
+// Called from threads and from the DRP callback
+void drp_trace(uint32_t type, uint32_t tiles, uint32_t arg) {
+    drp_trace_event_t * p_event;
+
+    core_util_critical_section_enter();
+    if (trace_frozen) {
+        core_util_critical_section_exit();
+        return;
+    }
+    p_event = &trace_ring[trace_pos & (DRP_TRACE_EVENT_MAX - 1)];
+    trace_pos++;
+    p_event->time_us = trace_timer.read_us();
+    p_event->type    = type;
+    p_event->tiles   = tiles;
+    p_event->arg     = arg;
+    core_util_critical_section_exit();
+}
+
+static void print_event(bool * p_first, const char * p_name, uint32_t tid, uint32_t begin, uint32_t end) {
+    printf("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%u,\"dur\":%u}\r\n",
+           *p_first ? "" : ",", p_name, (unsigned int)tid, (unsigned int)begin, (unsigned int)(end - begin));
+    *p_first = false;
+}
+
+static void print_instant(bool * p_first, const char * p_name, uint32_t tid, uint32_t time) {
+    printf("%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":%u,\"ts\":%u}\r\n",
+           *p_first ? "" : ",", p_name, (unsigned int)tid, (unsigned int)time);
+    *p_first = false;
+}
+
+static void print_thread_name(bool * p_first, uint32_t tid, const char * p_name, uint32_t no) {
+    char name[16];
+
+    sprintf(name, p_name, (int)no);
+    printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}\r\n",
+           *p_first ? "" : ",", (unsigned int)tid, name);
+    *p_first = false;
+}
+
+void drp_trace_dump(drp_trace_name_t p_name) {
+    uint32_t top;
+    uint32_t end;
+    uint32_t tile_begin[R_DK2_TILE_NUM];
+    uint32_t tile_stage[R_DK2_TILE_NUM];
+    uint32_t tile_owner[R_DK2_TILE_NUM] = {0};  // Stage that holds the tile, named on its circuits
+    uint32_t tile_track[R_DK2_TILE_NUM] = {0};
+    uint32_t load_begin = 0;
+    uint32_t activate_begin = 0;
+    uint32_t stage_begin[DRP_TRACE_TRACK_NUM] = {0};
+    uint32_t stage_no[DRP_TRACE_TRACK_NUM] = {0};
+    bool tile_busy[R_DK2_TILE_NUM] = {false};
+    bool first = true;
+
+    // Recording stops while the ring is printed
+    core_util_critical_section_enter();
+    trace_frozen = true;
+    end = trace_pos;
+    core_util_critical_section_exit();
+    top = (end > DRP_TRACE_EVENT_MAX) ? (end - DRP_TRACE_EVENT_MAX) : 0;
+
+    printf("---DRP TRACE BEGIN---\r\n");
+    printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\r\n");
+    for (uint32_t tile = 0; tile < R_DK2_TILE_NUM; tile++) {
+        print_thread_name(&first, tile, "tile %d", tile);
+    }
+    print_thread_name(&first, TRACK_LOADER, "Load/Activate", 0);
+    for (uint32_t track = DRP_TRACE_TRACK_DRP; track < DRP_TRACE_TRACK_CPU; track++) {
+        print_thread_name(&first, TRACK_STAGE + track, "Stage (DRP %d)", track - DRP_TRACE_TRACK_DRP);
+    }
+    print_thread_name(&first, TRACK_STAGE + DRP_TRACE_TRACK_CPU, "Stage (CPU)", 0);
+
+    for (uint32_t pos = top; pos < end; pos++) {
+        const drp_trace_event_t * p_event = &trace_ring[pos & (DRP_TRACE_EVENT_MAX - 1)];
+        uint32_t track = p_event->tiles % DRP_TRACE_TRACK_NUM;
+
+        switch (p_event->type) {
+            case DRP_TRACE_LOAD_BEGIN:
+                load_begin = p_event->time_us;
+                break;
+            case DRP_TRACE_LOAD_END:
+                print_event(&first, "Load", TRACK_LOADER, load_begin, p_event->time_us);
+                break;
+            case DRP_TRACE_ACTIVATE_BEGIN:
+                activate_begin = p_event->time_us;
+                break;
+            case DRP_TRACE_ACTIVATE_END:
+                print_event(&first, "Activate", TRACK_LOADER, activate_begin, p_event->time_us);
+                break;
+            case DRP_TRACE_START:
+                for (uint32_t tile = 0; tile < R_DK2_TILE_NUM; tile++) {
+                    if ((p_event->tiles & (1 << tile)) != 0) {
+                        tile_begin[tile] = p_event->time_us;
+                        tile_stage[tile] = tile_owner[tile];
+                        tile_busy[tile]  = true;
+                    }
+                }
+                break;
+            case DRP_TRACE_FINISH:
+                for (uint32_t tile = 0; tile < R_DK2_TILE_NUM; tile++) {
+                    if (((p_event->tiles & (1 << tile)) != 0) && tile_busy[tile]) {
+                        print_event(&first, p_name(tile_stage[tile]), tile, tile_begin[tile], p_event->time_us);
+                        tile_busy[tile] = false;
+                    }
+                }
+                break;
+            case DRP_TRACE_STAGE_BEGIN:
+                stage_begin[track] = p_event->time_us;
+                stage_no[track]    = p_event->arg;
+                break;
+            case DRP_TRACE_STAGE_TILES:
+                // Follows the STAGE_BEGIN of the track from the same thread
+                for (uint32_t tile = 0; tile < R_DK2_TILE_NUM; tile++) {
+                    if ((p_event->tiles & (1 << tile)) != 0) {
+                        tile_owner[tile] = stage_no[p_event->arg % DRP_TRACE_TRACK_NUM];
+                        tile_track[tile] = p_event->arg % DRP_TRACE_TRACK_NUM;
+                    }
+                }
+                break;
+            case DRP_TRACE_STAGE_END:
+                // A stage whose begin fell out of the ring is skipped
+                if ((stage_begin[track] != 0) && (stage_no[track] == p_event->arg)) {
+                    print_event(&first, p_name(p_event->arg), TRACK_STAGE + track, stage_begin[track], p_event->time_us);
+                }
+                stage_begin[track] = 0;
+                break;
+            case DRP_TRACE_STALL:
+                // The circuits that never finished end here
+                track = DRP_TRACE_TRACK_DRP;
+                for (uint32_t tile = 0; tile < R_DK2_TILE_NUM; tile++) {
+                    if ((p_event->tiles & (1 << tile)) != 0) {
+                        track = tile_track[tile];
+                        if (tile_busy[tile]) {
+                            print_event(&first, p_name(tile_stage[tile]), tile, tile_begin[tile], p_event->time_us);
+                            tile_busy[tile] = false;
+                        }
+                    }
+                }
+                print_instant(&first, "Stall", TRACK_STAGE + track, p_event->time_us);
+                break;
+            default:
+                break;
+        }
+    }
+    printf("]}\r\n");
+    printf("---DRP TRACE END---\r\n");
+
+    trace_pos = 0;
+    trace_frozen = false;
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef DRP_TRACE_H
+#define DRP_TRACE_H
+
+#include <stdint.h>
+
+/*! Timestamps of the DRP operations kept in a fixed ring buffer.
+    R_DK2_Load, R_DK2_Activate, every R_DK2_Start and every finish callback
+    are recorded with the tiles they concern, together with the begin and end
+    of each stage and the stalls. drp_trace_dump() prints the ring as Chrome trace-event JSON
+    (chrome://tracing, Perfetto) with one track per tile and one stage track per stream.
+    Enabled with the "drp-trace" option of mbed_app.json. */
+
+#if defined(MBED_CONF_APP_DRP_TRACE)
+#define DRP_TRACE_ENABLE        (MBED_CONF_APP_DRP_TRACE)
+#else
+#define DRP_TRACE_ENABLE        (0)
+#endif
+
+#define DRP_TRACE_EVENT_MAX     (1024)      /* Ring size, a power of 2 */
+
+#define DRP_TRACE_LOAD_BEGIN    (0)
+#define DRP_TRACE_LOAD_END      (1)
+#define DRP_TRACE_ACTIVATE_BEGIN (2)
+#define DRP_TRACE_ACTIVATE_END  (3)
+#define DRP_TRACE_START         (4)         /* tiles: tiles of the started circuit */
+#define DRP_TRACE_FINISH        (5)         /* tiles: tiles of the finished circuit */
+#define DRP_TRACE_STAGE_BEGIN   (6)         /* tiles: track, arg: stage number */
+#define DRP_TRACE_STAGE_END     (7)
+#define DRP_TRACE_STALL         (8)         /* tiles: tiles taken back from the stage, arg: stage number */
+#define DRP_TRACE_STAGE_TILES   (9)         /* tiles: tiles of the stage that began on the track, arg: track */
+
+#define DRP_TRACE_TRACK_DRP     (0)         /* + stream index */
+#define DRP_TRACE_TRACK_CPU     (2)
+#define DRP_TRACE_TRACK_NUM     (3)
+
+/* Returns the name of a stage number for the dump */
+typedef const char * (*drp_trace_name_t)(uint32_t arg);
+
+#if DRP_TRACE_ENABLE
+extern void drp_trace_init(void);
+extern void drp_trace(uint32_t type, uint32_t tiles, uint32_t arg);
+extern void drp_trace_dump(drp_trace_name_t p_name);
+#else
+static inline void drp_trace_init(void) {}
+static inline void drp_trace(uint32_t type, uint32_t tiles, uint32_t arg) { (void)type; (void)tiles; (void)arg; }
+static inline void drp_trace_dump(drp_trace_name_t p_name) { (void)p_name; }
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+#include "mbed.h"
+#include "histogram.h"
+
+#define BAR_WIDTH              (40)
+
+void histogram_init(histogram_t * p_hist, uint32_t bin_us) {
+    memset(p_hist, 0, sizeof(histogram_t));
+    p_hist->bin_us = bin_us;
+    p_hist->min    = 0xFFFFFFFF;
+}
+
+void histogram_add(histogram_t * p_hist, uint32_t value) {
+    uint32_t idx = value / p_hist->bin_us;
+
+    if (idx > HISTOGRAM_BIN_NUM) {
+        idx = HISTOGRAM_BIN_NUM;
+    }
+    p_hist->bin[idx]++;
+    p_hist->count++;
+    p_hist->sum += value;
+    if (value < p_hist->min) {
+        p_hist->min = value;
+    }
+    if (value > p_hist->max) {
+        p_hist->max = value;
+    }
+}
+
+uint32_t histogram_percentile(const histogram_t * p_hist, uint32_t percent) {
+    uint32_t target = (uint32_t)(((uint64_t)p_hist->count * percent + 99) / 100);
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < HISTOGRAM_BIN_NUM; i++) {
+        sum += p_hist->bin[i];
+        if ((sum >= target) && (sum != 0)) {
+            return (i + 1) * p_hist->bin_us;
+        }
+    }
+    return p_hist->max;
+}
+
+void histogram_print(const histogram_t * p_hist, const char * p_name) {
+    uint32_t peak = 0;
+
+    if (p_hist->count == 0) {
+        printf("%-16s: no sample\r\n", p_name);
+        return;
+    }
+    printf("%-16s: n %u avg %u min %u p50 %u p90 %u p99 %u max %u us\r\n", p_name, (unsigned int)p_hist->count,
+           (unsigned int)(p_hist->sum / p_hist->count), (unsigned int)p_hist->min,
+           (unsigned int)histogram_percentile(p_hist, 50), (unsigned int)histogram_percentile(p_hist, 90),
+           (unsigned int)histogram_percentile(p_hist, 99), (unsigned int)p_hist->max);
+
+    for (uint32_t i = 0; i <= HISTOGRAM_BIN_NUM; i++) {
+        if (p_hist->bin[i] > peak) {
+            peak = p_hist->bin[i];
+        }
+    }
+    for (uint32_t i = 0; i <= HISTOGRAM_BIN_NUM; i++) {
+        char bar[BAR_WIDTH + 1];
+        uint32_t len;
+
+        if (p_hist->bin[i] == 0) {
+            continue;
+        }
+        len = (p_hist->bin[i] * BAR_WIDTH + peak - 1) / peak;
+        memset(bar, '#', len);
+        bar[len] = '\0';
+        if (i < HISTOGRAM_BIN_NUM) {
+            printf("  <%7u %6u %s\r\n", (unsigned int)((i + 1) * p_hist->bin_us), (unsigned int)p_hist->bin[i], bar);
+        } else {
+            printf("  >=%6u %6u %s\r\n", (unsigned int)(i * p_hist->bin_us), (unsigned int)p_hist->bin[i], bar);
+        }
+    }
+}
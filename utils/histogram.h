@@ -0,0 +1,30 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+/*! Histogram of times in us with bins of a fixed width. Values beyond the
+    last bin are counted in an overflow bin. */
+
+#define HISTOGRAM_BIN_NUM      (64)
+
+typedef struct {
+    uint32_t bin_us;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t bin[HISTOGRAM_BIN_NUM + 1];
+} histogram_t;
+
+extern void histogram_init(histogram_t * p_hist, uint32_t bin_us);
+
+extern void histogram_add(histogram_t * p_hist, uint32_t value);
+
+/* Upper edge of the bin that holds the given percentile (max for the overflow bin) */
+extern uint32_t histogram_percentile(const histogram_t * p_hist, uint32_t percent);
+
+/* Summary line followed by one line per used bin */
+extern void histogram_print(const histogram_t * p_hist, const char * p_name);
+
+#endif
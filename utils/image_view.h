@@ -0,0 +1,47 @@
+#ifndef IMAGE_VIEW_H
+#define IMAGE_VIEW_H
+
+#include <stdint.h>
+
+/*! A view describes an 8-bit image inside a frame buffer without owning it.
+    Cropping a view only moves the base pointer, the rows keep the parent stride. */
+typedef struct {
+    uint8_t * base;
+    uint16_t  width;
+    uint16_t  height;
+    uint32_t  stride;
+} image_view_t;
+
+static inline image_view_t image_view(uint8_t * base, uint32_t width, uint32_t height, uint32_t stride) {
+    image_view_t view;
+
+    view.base   = base;
+    view.width  = width;
+    view.height = height;
+    view.stride = stride;
+    return view;
+}
+
+static inline image_view_t image_view_crop(const image_view_t * p_view, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    return image_view(p_view->base + (p_view->stride * y) + x, width, height, p_view->stride);
+}
+
+static inline uint8_t * image_view_row(const image_view_t * p_view, uint32_t y) {
+    return p_view->base + (p_view->stride * y);
+}
+
+/* Number of bytes from the first to the last pixel of the view */
+static inline uint32_t image_view_span(const image_view_t * p_view) {
+    return (p_view->height == 0) ? 0 : ((p_view->stride * (p_view->height - 1)) + p_view->width);
+}
+
+/* True if the rows are contiguous, i.e. the view can be handed to a library that has no stride parameter */
+static inline bool image_view_is_packed(const image_view_t * p_view) {
+    return (p_view->stride == p_view->width) || (p_view->height <= 1);
+}
+
+static inline bool image_view_overlaps(const image_view_t * p_a, const image_view_t * p_b) {
+    return (p_a->base < (p_b->base + image_view_span(p_b))) && (p_b->base < (p_a->base + image_view_span(p_a)));
+}
+
+#endif
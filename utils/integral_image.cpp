@@ -0,0 +1,126 @@
+#include "mbed.h"
+#include "integral_image.h"
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define INTEGRAL_USE_NEON      (1)
+#endif
+
+// Table rows bounding the window, relative to the first source row of the stripe
+typedef struct {
+    const image_view_t * p_src;
+    uint32_t      y0;           // Source rows y0 to y1 - 1 are in the window
+    uint32_t      y1;
+} window_t;
+
+static uint32_t row_top[INTEGRAL_WIDTH_MAX + 1];     // Table row y0
+static uint32_t row_bottom[INTEGRAL_WIDTH_MAX + 1];  // Table row y1
+
+// Adds the running sum of an image row to a table row
+static void add_row(uint32_t * p_row, const uint8_t * p_src, uint32_t width) {
+    uint32_t sum = 0;
+    uint32_t x = 0;
+
+#if INTEGRAL_USE_NEON
+    // Prefix sum of 8 pixels in three shifted adds, then the carry of the pixels to the left
+    const uint16x8_t zero = vdupq_n_u16(0);
+
+    for (; (x + 8) <= width; x += 8) {
+        uint16x8_t pre = vmovl_u8(vld1_u8(&p_src[x]));
+        uint32x4_t lo;
+        uint32x4_t hi;
+
+        pre = vaddq_u16(pre, vextq_u16(zero, pre, 7));
+        pre = vaddq_u16(pre, vextq_u16(zero, pre, 6));
+        pre = vaddq_u16(pre, vextq_u16(zero, pre, 4));
+        lo = vaddw_u16(vdupq_n_u32(sum), vget_low_u16(pre));
+        hi = vaddw_u16(vdupq_n_u32(sum), vget_high_u16(pre));
+        sum = vgetq_lane_u32(hi, 3);
+        vst1q_u32(&p_row[x + 1], vaddq_u32(lo, vld1q_u32(&p_row[x + 1])));
+        vst1q_u32(&p_row[x + 5], vaddq_u32(hi, vld1q_u32(&p_row[x + 5])));
+    }
+#endif
+    for (; x < width; x++) {
+        sum += p_src[x];
+        p_row[x + 1] += sum;
+    }
+}
+
+// Both rows start at the first source row read by image row top
+static void window_begin(window_t * p_win, const image_view_t * p_src, uint32_t radius, uint32_t top) {
+    p_win->p_src = p_src;
+    p_win->y0    = (top > radius) ? (top - radius) : 0;
+    p_win->y1    = p_win->y0;
+    memset(row_top, 0, (p_src->width + 1) * sizeof(uint32_t));
+    memset(row_bottom, 0, (p_src->width + 1) * sizeof(uint32_t));
+}
+
+// Moves the window to image row y and returns its number of rows
+static uint32_t window_move(window_t * p_win, uint32_t radius, uint32_t y) {
+    const image_view_t * p_src = p_win->p_src;
+    uint32_t y0 = (y > radius) ? (y - radius) : 0;
+    uint32_t y1 = ((y + radius + 1) < p_src->height) ? (y + radius + 1) : p_src->height;
+
+    while (p_win->y1 < y1) {
+        add_row(row_bottom, image_view_row(p_src, p_win->y1++), p_src->width);
+    }
+    while (p_win->y0 < y0) {
+        add_row(row_top, image_view_row(p_src, p_win->y0++), p_src->width);
+    }
+    return y1 - y0;
+}
+
+static inline uint32_t get_box_sum(uint32_t x0, uint32_t x1) {
+    return (row_bottom[x1] - row_bottom[x0]) - (row_top[x1] - row_top[x0]);
+}
+
+void integral_adaptive_threshold(const image_view_t * p_src, const image_view_t * p_dst,
+                                 uint32_t radius, int32_t offset, uint32_t top, uint32_t rows) {
+    uint32_t width = p_src->width;
+    window_t win;
+
+    window_begin(&win, p_src, radius, top);
+    for (uint32_t y = top; y < (top + rows); y++) {
+        uint32_t box_rows = window_move(&win, radius, y);
+        const uint8_t * p_in = image_view_row(p_src, y);
+        uint8_t * p_out = image_view_row(p_dst, y);
+
+        // pixel > sum / area - offset, compared as (pixel + offset) * area > sum without a division.
+        // Both sides stay below 2^31 for an offset within +-255 on a VGA frame.
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t x0 = (x > radius) ? (x - radius) : 0;
+            uint32_t x1 = ((x + radius + 1) < width) ? (x + radius + 1) : width;
+            int32_t lhs = ((int32_t)p_in[x] + offset) * (int32_t)((x1 - x0) * box_rows);
+
+            p_out[x] = (lhs > (int32_t)get_box_sum(x0, x1)) ? 255 : 0;
+        }
+    }
+}
+
+void integral_box_blur(const image_view_t * p_src, const image_view_t * p_dst,
+                       uint32_t radius, uint32_t top, uint32_t rows) {
+    uint32_t width = p_src->width;
+    window_t win;
+
+    window_begin(&win, p_src, radius, top);
+    for (uint32_t y = top; y < (top + rows); y++) {
+        uint32_t box_rows = window_move(&win, radius, y);
+        uint32_t full_area = ((2 * radius) + 1) * box_rows;
+        // 2^48 / area rounded up, exact for any 8-bit box: the mean is (sum + area / 2) * recip >> 48
+        uint64_t full_recip = ((1ull << 48) + full_area - 1) / full_area;
+        uint8_t * p_out = image_view_row(p_dst, y);
+
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t x0 = (x > radius) ? (x - radius) : 0;
+            uint32_t x1 = ((x + radius + 1) < width) ? (x + radius + 1) : width;
+            uint32_t sum = get_box_sum(x0, x1);
+            uint32_t area = (x1 - x0) * box_rows;
+
+            // Only the columns near the left and right border have a clipped box
+            if (area == full_area) {
+                p_out[x] = (uint8_t)(((uint64_t)(sum + (area / 2)) * full_recip) >> 48);
+            } else {
+                p_out[x] = (uint8_t)((sum + (area / 2)) / area);
+            }
+        }
+    }
+}
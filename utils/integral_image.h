@@ -0,0 +1,28 @@
+#ifndef INTEGRAL_IMAGE_H
+#define INTEGRAL_IMAGE_H
+
+#include <stdint.h>
+#include "image_view.h"
+
+/*! Box filters on the summed-area table (integral image) of an 8-bit image.
+    The sum of any box takes four table reads whatever its size. The table is
+    not kept: a stripe only needs the two table rows bounding the window of the
+    image row it produces, and rolls them down the image by adding the running
+    sum of each source row as the window passes it. The two rows count from
+    the first source row the stripe reads, so a stripe needs nothing from the
+    stripes above and the table costs 2 * (width + 1) words. Every function
+    works on one stripe of image rows, on the same partition as the DRP
+    libraries, and is called from one thread. */
+
+#define INTEGRAL_WIDTH_MAX     (1280)
+
+/* 255 where the pixel is above the mean of the (2 * radius + 1)^2 box around it minus offset, 0 elsewhere.
+   The box is clipped at the image border, offset is within -255 to 255. */
+extern void integral_adaptive_threshold(const image_view_t * p_src, const image_view_t * p_dst,
+                                        uint32_t radius, int32_t offset, uint32_t top, uint32_t rows);
+
+/* Rounded mean of the (2 * radius + 1)^2 box, clipped at the image border */
+extern void integral_box_blur(const image_view_t * p_src, const image_view_t * p_dst,
+                              uint32_t radius, uint32_t top, uint32_t rows);
+
+#endif
@@ -0,0 +1,112 @@
+#include "mbed.h"
+#include "dcache-control.h"
+#include "memory_tier.h"
+
+static uint32_t probe_bandwidth(const uint8_t * p_probe, uint32_t size) {
+    const uint32_t * p_word = (const uint32_t *)p_probe;
+    volatile uint32_t sink;
+    uint32_t sum = 0;
+    uint32_t time;
+    Timer probe_timer;
+
+    if (size > MEMORY_TIER_PROBE_SIZE) {
+        size = MEMORY_TIER_PROBE_SIZE;
+    }
+    size &= ~(MEMORY_TIER_ALIGN - 1);
+    if ((p_probe == NULL) || (size == 0)) {
+        return 0;
+    }
+    // Read from the memory, not from lines left in the cache. The probed areas are not in use yet.
+    dcache_invalidate((void *)p_probe, size);
+
+    probe_timer.start();
+    for (uint32_t i = 0; i < (size / sizeof(uint32_t)); i += 8) {
+        sum += p_word[i];   // One word per cache line is enough to pull the line in
+    }
+    time = probe_timer.read_us();
+    sink = sum;
+    (void)sink;
+
+    if (time == 0) {
+        time = 1;
+    }
+    return size / time;
+}
+
+void memory_tier_init(memory_tier_t * p_tier, uint32_t tier_num) {
+    for (uint32_t i = 0; i < tier_num; i++) {
+        p_tier[i].bandwidth = probe_bandwidth(p_tier[i].p_probe, p_tier[i].probe_size);
+        p_tier[i].used = 0;
+    }
+}
+
+// Access per byte in 1/256 units, the key items are placed by
+static uint32_t get_density(const memory_item_t * p_item) {
+    if (p_item->size == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)p_item->access << 8) / p_item->size);
+}
+
+bool memory_tier_place(memory_tier_t * p_tier, uint32_t tier_num, memory_item_t * p_item, uint32_t item_num) {
+    uint8_t order[256];
+    bool result = true;
+
+    if (item_num > sizeof(order)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < tier_num; i++) {
+        p_tier[i].used = 0;
+    }
+
+    // Stable sort: items with the same density keep the declaration order
+    for (uint32_t i = 0; i < item_num; i++) {
+        uint32_t pos = i;
+
+        while ((pos > 0) && (get_density(&p_item[order[pos - 1]]) < get_density(&p_item[i]))) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+    }
+
+    for (uint32_t i = 0; i < item_num; i++) {
+        memory_item_t * p = &p_item[order[i]];
+        uint32_t size = (p->size + (MEMORY_TIER_ALIGN - 1)) & ~(MEMORY_TIER_ALIGN - 1);
+        uint32_t best = MEMORY_TIER_NONE;
+
+        p->tier = MEMORY_TIER_NONE;
+        p->p_addr = NULL;
+        if (p->tier_mask == 0) {
+            continue;
+        }
+        for (uint32_t j = 0; j < tier_num; j++) {
+            if (((p->tier_mask & (1u << j)) != 0) && ((p_tier[j].used + size) <= p_tier[j].size) &&
+                ((best == MEMORY_TIER_NONE) || (p_tier[j].bandwidth > p_tier[best].bandwidth))) {
+                best = j;
+            }
+        }
+        if (best == MEMORY_TIER_NONE) {
+            result = false;
+            continue;
+        }
+        p->tier = best;
+        if (p_tier[best].p_base != NULL) {
+            p->p_addr = p_tier[best].p_base + p_tier[best].used;
+        }
+        p_tier[best].used += size;
+    }
+
+    return result;
+}
+
+uint32_t memory_tier_predict(const memory_tier_t * p_tier, const memory_item_t * p_item, uint32_t item_num) {
+    uint32_t time = 0;
+
+    for (uint32_t i = 0; i < item_num; i++) {
+        if ((p_item[i].tier != MEMORY_TIER_NONE) && (p_tier[p_item[i].tier].bandwidth != 0)) {
+            time += p_item[i].access / p_tier[p_item[i].tier].bandwidth;
+        }
+    }
+    return time;
+}
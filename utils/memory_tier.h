@@ -0,0 +1,49 @@
+#ifndef MEMORY_TIER_H
+#define MEMORY_TIER_H
+
+#include <stdint.h>
+
+/*! Placement of buffers across memory tiers.
+    A tier has a declared capacity and a read bandwidth measured at start-up.
+    Items (buffers, configuration data) carry the bytes they are accessed per
+    frame, from telemetry, and are placed greedily: the most densely accessed
+    item first, each into the fastest allowed tier that still has room.
+    A tier with an arena hands out addresses in it; a tier without one (the
+    items stay where they are, or another allocator owns the memory) only
+    accounts for the capacity. Placement is only valid while none of the
+    items is in use. */
+
+#define MEMORY_TIER_MAX         (8)
+#define MEMORY_TIER_ALIGN       (32)
+#define MEMORY_TIER_PROBE_SIZE  (256 * 1024)    /* Larger than the L2 cache */
+#define MEMORY_TIER_NONE        (0xFFFFFFFF)
+
+typedef struct {
+    const char *    name;
+    uint8_t *       p_base;     /* Arena the items are placed in (NULL: capacity only) */
+    uint32_t        size;       /* Declared capacity in bytes */
+    const uint8_t * p_probe;    /* Memory read by the bandwidth probe (NULL: not measured) */
+    uint32_t        probe_size;
+    uint32_t        bandwidth;  /* Measured, bytes/us */
+    uint32_t        used;
+} memory_tier_t;
+
+typedef struct {
+    const char *    name;
+    uint32_t        size;
+    uint32_t        tier_mask;  /* Bit n: the item may be placed in tier n (0: not placed) */
+    uint32_t        access;     /* Bytes accessed per frame */
+    uint32_t        tier;       /* Placed tier (MEMORY_TIER_NONE: not placed) */
+    uint8_t *       p_addr;     /* Address in the arena of the tier (NULL without an arena) */
+} memory_item_t;
+
+/* Measures the bandwidth of each tier by reading its probe with the data cache invalidated. */
+extern void memory_tier_init(memory_tier_t * p_tier, uint32_t tier_num);
+
+/* Places all the items again. Returns false if an item fits in none of its tiers. */
+extern bool memory_tier_place(memory_tier_t * p_tier, uint32_t tier_num, memory_item_t * p_item, uint32_t item_num);
+
+/* Time in us the accesses of one frame take with the current placement. */
+extern uint32_t memory_tier_predict(const memory_tier_t * p_tier, const memory_item_t * p_item, uint32_t item_num);
+
+#endif
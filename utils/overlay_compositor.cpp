@@ -0,0 +1,215 @@
+#include "mbed.h"
+#include "AsciiFont.h"
+#include "overlay_compositor.h"
+
+#define GLYPH_CODE_FIRST       (0x20)
+#define GLYPH_CODE_LAST        (0x7E)
+#define GLYPH_NUM              (GLYPH_CODE_LAST - GLYPH_CODE_FIRST + 1)
+#define GLYPH_PIX_WIDTH        (AsciiFont::CHAR_PIX_WIDTH * OVERLAY_TEXT_SCALE)
+#define GLYPH_PIX_HEIGHT       (AsciiFont::CHAR_PIX_HEIGHT * OVERLAY_TEXT_SCALE)
+#define GLYPH_WORD_WIDTH       (GLYPH_PIX_WIDTH / 4)
+#define TEXT_LINE_PITCH        ((AsciiFont::CHAR_PIX_HEIGHT + 1) * OVERLAY_TEXT_SCALE)
+#define TEXT_COLOR             (1)
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+} overlay_rect_t;
+
+static uint8_t * p_overlay_buf;
+static uint32_t overlay_width;
+static uint32_t overlay_height;
+static uint32_t overlay_stride;
+static uint32_t text_col_num;
+static uint32_t text_line_num;
+
+// Glyphs pre-rasterized at OVERLAY_TEXT_SCALE, one word per 4 pixels
+static uint32_t glyph_cache[GLYPH_NUM][GLYPH_PIX_HEIGHT][GLYPH_WORD_WIDTH];
+static uint8_t glyph_raster[GLYPH_PIX_HEIGHT * GLYPH_PIX_WIDTH]__attribute((aligned(4)));
+
+// What is currently on the screen
+static char text_shadow[OVERLAY_TEXT_LINE_MAX][OVERLAY_TEXT_COL_MAX];
+static uint8_t text_len[OVERLAY_TEXT_LINE_MAX];
+static overlay_rect_t dirty_rect[OVERLAY_DIRTY_RECT_MAX];
+static uint32_t dirty_rect_num;
+static bool dirty_rect_overflow;
+
+static void rasterize_glyphs(void) {
+    AsciiFont raster_font(glyph_raster, GLYPH_PIX_WIDTH, GLYPH_PIX_HEIGHT, GLYPH_PIX_WIDTH, 1);
+
+    for (uint32_t code = GLYPH_CODE_FIRST; code <= GLYPH_CODE_LAST; code++) {
+        memset(glyph_raster, 0, sizeof(glyph_raster));
+        raster_font.DrawChar((char)code, 0, 0, TEXT_COLOR, OVERLAY_TEXT_SCALE);
+        memcpy(glyph_cache[code - GLYPH_CODE_FIRST], glyph_raster, sizeof(glyph_raster));
+    }
+}
+
+static void blit_glyph(uint32_t line, uint32_t col, char c) {
+    uint32_t code = (uint8_t)c;
+
+    if ((code < GLYPH_CODE_FIRST) || (code > GLYPH_CODE_LAST)) {
+        code = '?';
+    }
+
+    const uint32_t (* p_glyph)[GLYPH_WORD_WIDTH] = glyph_cache[code - GLYPH_CODE_FIRST];
+    uint32_t x = OVERLAY_TEXT_X + (GLYPH_PIX_WIDTH * col);
+    uint32_t y = OVERLAY_TEXT_Y + (TEXT_LINE_PITCH * line);
+    uint32_t * p_dst = (uint32_t *)&p_overlay_buf[(overlay_stride * y) + x];
+
+    for (uint32_t row = 0; row < GLYPH_PIX_HEIGHT; row++) {
+        for (uint32_t word = 0; word < GLYPH_WORD_WIDTH; word++) {
+            p_dst[word] = p_glyph[row][word];
+        }
+        p_dst += (overlay_stride / 4);
+    }
+}
+
+static void fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint8_t color) {
+    uint8_t * p_dst = &p_overlay_buf[(overlay_stride * y) + x];
+
+    for (int32_t row = 0; row < h; row++) {
+        memset(p_dst, color, w);
+        p_dst += overlay_stride;
+    }
+}
+
+static void draw_outline(const overlay_rect_t * p_rect, uint8_t color) {
+    fill_rect(p_rect->x, p_rect->y, p_rect->w, 1, color);
+    fill_rect(p_rect->x, p_rect->y + p_rect->h - 1, p_rect->w, 1, color);
+    fill_rect(p_rect->x, p_rect->y, 1, p_rect->h, color);
+    fill_rect(p_rect->x + p_rect->w - 1, p_rect->y, 1, p_rect->h, color);
+}
+
+// The text cells an erased outline went through no longer show their glyph, the next
+// overlay_draw_text redraws them
+static void invalidate_text(const overlay_rect_t * p_rect) {
+    for (uint32_t line = 0; line < text_line_num; line++) {
+        int32_t top    = OVERLAY_TEXT_Y + (TEXT_LINE_PITCH * line);
+        int32_t bottom = top + GLYPH_PIX_HEIGHT;
+
+        if ((bottom <= p_rect->y) || (top >= (p_rect->y + p_rect->h))) {
+            continue;
+        }
+        for (uint32_t col = 0; col < text_col_num; col++) {
+            int32_t left  = OVERLAY_TEXT_X + (GLYPH_PIX_WIDTH * col);
+            int32_t right = left + GLYPH_PIX_WIDTH;
+
+            if ((right <= p_rect->x) || (left >= (p_rect->x + p_rect->w))) {
+                continue;
+            }
+            // Inside the outline
+            if ((left > p_rect->x) && (right < (p_rect->x + p_rect->w)) &&
+                (top > p_rect->y) && (bottom < (p_rect->y + p_rect->h))) {
+                continue;
+            }
+            text_shadow[line][col] = '\0';
+        }
+    }
+}
+
+static void clear_all(void) {
+    memset(p_overlay_buf, 0, overlay_stride * overlay_height);
+    memset(text_shadow, ' ', sizeof(text_shadow));
+    memset(text_len, 0, sizeof(text_len));
+    dirty_rect_num = 0;
+    dirty_rect_overflow = false;
+}
+
+void overlay_init(uint8_t * p_buf, uint32_t width, uint32_t height, uint32_t stride) {
+    p_overlay_buf  = p_buf;
+    overlay_width  = width;
+    overlay_height = height;
+    overlay_stride = stride;
+
+    text_col_num = (width - OVERLAY_TEXT_X) / GLYPH_PIX_WIDTH;
+    if (text_col_num > OVERLAY_TEXT_COL_MAX) {
+        text_col_num = OVERLAY_TEXT_COL_MAX;
+    }
+    text_line_num = (height - OVERLAY_TEXT_Y - GLYPH_PIX_HEIGHT) / TEXT_LINE_PITCH + 1;
+    if (text_line_num > OVERLAY_TEXT_LINE_MAX) {
+        text_line_num = OVERLAY_TEXT_LINE_MAX;
+    }
+
+    rasterize_glyphs();
+    clear_all();
+}
+
+void overlay_draw_text(uint32_t line, const char * str) {
+    uint32_t len = 0;
+    uint32_t end;
+
+    if (line >= text_line_num) {
+        return;
+    }
+    while ((str[len] != '\0') && (len < text_col_num)) {
+        len++;
+    }
+    end = (len > text_len[line]) ? len : text_len[line];
+
+    for (uint32_t col = 0; col < end; col++) {
+        char c = (col < len) ? str[col] : ' ';
+
+        if (c != text_shadow[line][col]) {
+            blit_glyph(line, col, c);
+            text_shadow[line][col] = c;
+        }
+    }
+    text_len[line] = len;
+}
+
+void overlay_draw_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint8_t color) {
+    overlay_rect_t rect;
+
+    // Clip to the overlay
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if ((x + w) > (int32_t)overlay_width) {
+        w = overlay_width - x;
+    }
+    if ((y + h) > (int32_t)overlay_height) {
+        h = overlay_height - y;
+    }
+    if ((w <= 0) || (h <= 0)) {
+        return;
+    }
+
+    rect.x = x;
+    rect.y = y;
+    rect.w = w;
+    rect.h = h;
+    draw_outline(&rect, color);
+
+    if (dirty_rect_num < OVERLAY_DIRTY_RECT_MAX) {
+        dirty_rect[dirty_rect_num++] = rect;
+    } else {
+        dirty_rect_overflow = true;
+    }
+}
+
+void overlay_clear_shapes(void) {
+    if (dirty_rect_overflow) {
+        // The region list is incomplete, fall back to a full clear
+        clear_all();
+        return;
+    }
+    for (uint32_t i = 0; i < dirty_rect_num; i++) {
+        draw_outline(&dirty_rect[i], 0);
+        invalidate_text(&dirty_rect[i]);
+    }
+    dirty_rect_num = 0;
+}
+
+void overlay_clear(void) {
+    for (uint32_t line = 0; line < text_line_num; line++) {
+        overlay_draw_text(line, "");
+    }
+    overlay_clear_shapes();
+}
@@ -0,0 +1,31 @@
+#ifndef OVERLAY_COMPOSITOR_H
+#define OVERLAY_COMPOSITOR_H
+
+#include <stdint.h>
+
+/*! Text cells are aligned to 32-bit words so that every glyph row can be written
+    to the non-cacheable overlay buffer with word accesses only. */
+#define OVERLAY_TEXT_SCALE       (2)
+#define OVERLAY_TEXT_X           (8)
+#define OVERLAY_TEXT_Y           (5)
+#define OVERLAY_TEXT_LINE_MAX    (16)
+#define OVERLAY_TEXT_COL_MAX     (52)
+#define OVERLAY_DIRTY_RECT_MAX   (128)
+
+/* Initializes the compositor and clears the whole overlay once. */
+extern void overlay_init(uint8_t * p_buf, uint32_t width, uint32_t height, uint32_t stride);
+
+/* Draws a text line. Only the character cells that differ from the previous call are written. */
+extern void overlay_draw_text(uint32_t line, const char * str);
+
+/* Draws a rectangle outline and records it as a dirty region. */
+extern void overlay_draw_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint8_t color);
+
+/* Erases the rectangles drawn since the previous call. The text cells they went through
+   are redrawn by the next overlay_draw_text of their line. */
+extern void overlay_clear_shapes(void);
+
+/* Erases everything drawn so far, touching only the regions that were written. */
+extern void overlay_clear(void);
+
+#endif
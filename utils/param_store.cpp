@@ -0,0 +1,97 @@
+#include "mbed.h"
+#include "param_store.h"
+
+static const param_def_t * param_def = NULL;
+static uint32_t param_num = 0;
+static param_set_t param_buf[2];
+static uint32_t front = 0;
+static bool dirty = false;
+static uint32_t writing = 0;
+
+void param_store_init(const param_def_t * p_def, uint32_t num) {
+    if (num > PARAM_STORE_MAX) {
+        num = PARAM_STORE_MAX;
+    }
+    param_def = p_def;
+    param_num = num;
+    memset(param_buf, 0, sizeof(param_buf));
+    for (uint32_t i = 0; i < num; i++) {
+        param_buf[0].value[i] = p_def[i].init;
+    }
+    param_buf[1] = param_buf[0];
+    front   = 0;
+    dirty   = false;
+    writing = 0;
+}
+
+int32_t param_store_find(const char * p_name) {
+    for (uint32_t i = 0; i < param_num; i++) {
+        if (strcmp(param_def[i].name, p_name) == 0) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+bool param_store_is_valid(uint32_t id, int32_t value) {
+    return (id < param_num) && (value >= param_def[id].min) && (value <= param_def[id].max);
+}
+
+bool param_store_set(uint32_t id, int32_t value) {
+    if (!param_store_is_valid(id, value)) {
+        return false;
+    }
+    core_util_critical_section_enter();
+    param_buf[front ^ 1].value[id] = value;
+    dirty = true;
+    core_util_critical_section_exit();
+
+    return true;
+}
+
+void param_store_begin(void) {
+    core_util_critical_section_enter();
+    writing++;
+    core_util_critical_section_exit();
+}
+
+void param_store_end(void) {
+    core_util_critical_section_enter();
+    if (writing > 0) {
+        writing--;
+    }
+    core_util_critical_section_exit();
+}
+
+void param_store_latch(param_set_t * p_set) {
+    core_util_critical_section_enter();
+    if (dirty && (writing == 0)) {
+        // The new back set starts from the new front set
+        param_buf[front ^ 1].seq = param_buf[front].seq + 1;
+        front ^= 1;
+        param_buf[front ^ 1] = param_buf[front];
+        dirty = false;
+    }
+    *p_set = param_buf[front];
+    core_util_critical_section_exit();
+}
+
+void param_store_print(void) {
+    param_set_t cur;
+    param_set_t next;
+
+    core_util_critical_section_enter();
+    cur  = param_buf[front];
+    next = param_buf[front ^ 1];
+    core_util_critical_section_exit();
+
+    for (uint32_t i = 0; i < param_num; i++) {
+        printf("%-16s %6d", param_def[i].name, (int)cur.value[i]);
+        if (next.value[i] != cur.value[i]) {
+            printf(" -> %6d", (int)next.value[i]);
+        } else {
+            printf("          ");
+        }
+        printf("  (%d..%d)\r\n", (int)param_def[i].min, (int)param_def[i].max);
+    }
+}
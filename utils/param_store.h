@@ -0,0 +1,49 @@
+#ifndef PARAM_STORE_H
+#define PARAM_STORE_H
+
+#include <stdint.h>
+
+/*! Run-time parameters of the DRP stages, double-buffered.
+    Updates from any thread go to the back set. The frame loop latches the
+    parameters at the start of every frame: the back set becomes the front
+    set in one step if it has changed, and the frame works on a copy of the
+    front set. Updates grouped by param_store_begin/end are published
+    together, and a frame in flight never sees a change. */
+
+#define PARAM_STORE_MAX        (16)
+
+typedef struct {
+    const char * name;
+    int32_t      min;
+    int32_t      max;
+    int32_t      init;
+} param_def_t;
+
+typedef struct {
+    int32_t  value[PARAM_STORE_MAX];
+    uint32_t seq;                   /* Incremented on every swap */
+} param_set_t;
+
+/* p_def must stay valid, num is at most PARAM_STORE_MAX */
+extern void param_store_init(const param_def_t * p_def, uint32_t num);
+
+/* Index of the parameter with the given name, -1 if there is none */
+extern int32_t param_store_find(const char * p_name);
+
+/* The value is within the range of the parameter */
+extern bool param_store_is_valid(uint32_t id, int32_t value);
+
+/* Writes the back set. Returns false if the value is out of range. */
+extern bool param_store_set(uint32_t id, int32_t value);
+
+/* Holds back the swap while several parameters are written */
+extern void param_store_begin(void);
+extern void param_store_end(void);
+
+/* Called at a frame boundary: swaps the sets if the back set has changed, then copies the front set */
+extern void param_store_latch(param_set_t * p_set);
+
+/* One line per parameter: the current value, the pending one and the range */
+extern void param_store_print(void);
+
+#endif
@@ -0,0 +1,47 @@
+#include "mbed.h"
+#include "pgm_file.h"
+
+bool pgm_read(const char * p_path, const image_view_t * p_dst) {
+    FILE * fp = fopen(p_path, "rb");
+    unsigned int width;
+    unsigned int height;
+    unsigned int max_val;
+    bool result = true;
+
+    if (fp == NULL) {
+        return false;
+    }
+    // A single whitespace separates the header from the pixels
+    if ((fscanf(fp, "P5 %u %u %u", &width, &height, &max_val) != 3) || (fgetc(fp) == EOF) ||
+        (width != p_dst->width) || (height != p_dst->height) || (max_val > 255)) {
+        result = false;
+    }
+    for (uint32_t y = 0; result && (y < p_dst->height); y++) {
+        if (fread(image_view_row(p_dst, y), 1, p_dst->width, fp) != p_dst->width) {
+            result = false;
+        }
+    }
+    fclose(fp);
+
+    return result;
+}
+
+bool pgm_write(const char * p_path, const image_view_t * p_src) {
+    FILE * fp = fopen(p_path, "wb");
+    bool result = true;
+
+    if (fp == NULL) {
+        return false;
+    }
+    fprintf(fp, "P5\n%u %u\n255\n", (unsigned int)p_src->width, (unsigned int)p_src->height);
+    for (uint32_t y = 0; result && (y < p_src->height); y++) {
+        if (fwrite(image_view_row(p_src, y), 1, p_src->width, fp) != p_src->width) {
+            result = false;
+        }
+    }
+    if (fclose(fp) != 0) {
+        result = false;
+    }
+
+    return result;
+}
@@ -0,0 +1,13 @@
+#ifndef PGM_FILE_H
+#define PGM_FILE_H
+
+#include "image_view.h"
+
+/*! Binary PGM (P5, 8-bit) files read into and written from image views. */
+
+/* Fails if the file is missing or its size differs from the view. */
+extern bool pgm_read(const char * p_path, const image_view_t * p_dst);
+
+extern bool pgm_write(const char * p_path, const image_view_t * p_src);
+
+#endif
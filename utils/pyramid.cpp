@@ -0,0 +1,85 @@
+#include "mbed.h"
+#include "pyramid.h"
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PYRAMID_USE_NEON       (1)
+#endif
+
+uint32_t pyramid_size(uint32_t width, uint32_t height) {
+    uint32_t size = 0;
+
+    for (uint32_t level = 1; level < PYRAMID_LEVEL_NUM; level++) {
+        size += (width >> level) * (height >> level);
+    }
+    return size;
+}
+
+image_view_t pyramid_level(uint8_t * p_buf, uint32_t width, uint32_t height, uint32_t level) {
+    uint32_t offset = 0;
+
+    for (uint32_t i = 1; i < level; i++) {
+        offset += (width >> i) * (height >> i);
+    }
+    return image_view(p_buf + offset, width >> level, height >> level, width >> level);
+}
+
+image_view_t pyramid_view(uint8_t * p_buf, uint32_t width, uint32_t height) {
+    uint32_t row = width >> 1;
+
+    return image_view(p_buf, row, (pyramid_size(width, height) + row - 1) / row, row);
+}
+
+// Every other pixel of a row
+static void subsample_row(const uint8_t * p_src, uint8_t * p_dst, uint32_t dst_width) {
+    uint32_t x = 0;
+
+#if PYRAMID_USE_NEON
+    for (; (x + 16) <= dst_width; x += 16) {
+        uint8x16x2_t pair = vld2q_u8(&p_src[x * 2]);
+
+        vst1q_u8(&p_dst[x], pair.val[0]);
+    }
+#endif
+    for (; x < dst_width; x++) {
+        p_dst[x] = p_src[x * 2];
+    }
+}
+
+// 2x2 mean of two rows, rounded
+static void mean_row(const uint8_t * p_src0, const uint8_t * p_src1, uint8_t * p_dst, uint32_t dst_width) {
+    uint32_t x = 0;
+
+#if PYRAMID_USE_NEON
+    for (; (x + 8) <= dst_width; x += 8) {
+        uint16x8_t sum = vpaddlq_u8(vld1q_u8(&p_src0[x * 2]));
+
+        sum = vpadalq_u8(sum, vld1q_u8(&p_src1[x * 2]));
+        vst1_u8(&p_dst[x], vrshrn_n_u16(sum, 2));
+    }
+#endif
+    for (; x < dst_width; x++) {
+        p_dst[x] = (p_src0[x * 2] + p_src0[(x * 2) + 1] + p_src1[x * 2] + p_src1[(x * 2) + 1] + 2) >> 2;
+    }
+}
+
+void pyramid_build(const image_view_t * p_src, uint8_t * p_buf) {
+    image_view_t level[PYRAMID_LEVEL_NUM];
+
+    level[0] = *p_src;
+    for (uint32_t i = 1; i < PYRAMID_LEVEL_NUM; i++) {
+        level[i] = pyramid_level(p_buf, p_src->width, p_src->height, i);
+    }
+
+    // A row of level 1 completes a row pair of level 2 every other row, and so on,
+    // so the coarser rows are made while the finer ones are still in the cache
+    for (uint32_t y = 0; y < level[1].height; y++) {
+        uint32_t row = y;
+
+        subsample_row(image_view_row(&level[0], y * 2), image_view_row(&level[1], y), level[1].width);
+        for (uint32_t i = 2; (i < PYRAMID_LEVEL_NUM) && ((row & 1) != 0); i++) {
+            row >>= 1;
+            mean_row(image_view_row(&level[i - 1], (row * 2)), image_view_row(&level[i - 1], (row * 2) + 1),
+                     image_view_row(&level[i], row), level[i].width);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <stdint.h>
+#include "image_view.h"
+
+/*! Image pyramid of 1/2, 1/4 and 1/8 levels built from a low-pass filtered
+    full-resolution image (level 0, e.g. the output of GaussianBlur) in one
+    pass. Level 1 takes every other pixel of level 0, and each coarser level
+    is the 2x2 mean of the one above. The levels are packed one after
+    another in a single buffer of pyramid_size() bytes, every level a packed
+    view that can be handed to a DRP library. */
+
+#define PYRAMID_LEVEL_NUM      (4)     /* Level 0 is the source and is not stored */
+
+/* Bytes of the levels 1 to PYRAMID_LEVEL_NUM - 1 */
+extern uint32_t pyramid_size(uint32_t width, uint32_t height);
+
+/* View of a level (1 or coarser) of the pyramid of a width x height image stored in p_buf */
+extern image_view_t pyramid_level(uint8_t * p_buf, uint32_t width, uint32_t height, uint32_t level);
+
+/* View covering the whole buffer, the destination of the pyramid stage */
+extern image_view_t pyramid_view(uint8_t * p_buf, uint32_t width, uint32_t height);
+
+/* Builds all the levels. width and height of p_src must be multiples of 2^(PYRAMID_LEVEL_NUM - 1). */
+extern void pyramid_build(const image_view_t * p_src, uint8_t * p_buf);
+
+#endif
@@ -0,0 +1,56 @@
+#include "mbed.h"
+#include "resize_bilinear.h"
+
+#define FRAC_BITS              (8)
+#define FRAC_ONE               (1 << FRAC_BITS)
+
+static image_view_t src_view;
+static image_view_t dst_view;
+static uint16_t x_pos[RESIZE_WIDTH_MAX];
+static uint8_t  x_frac[RESIZE_WIDTH_MAX];
+
+// Pixel centers are aligned: src = (dst + 0.5) * src_size / dst_size - 0.5, in 16.16 fixed point
+static int32_t map_pos(uint32_t dst_pos, uint32_t src_size, uint32_t dst_size) {
+    int64_t pos = ((((int64_t)dst_pos * 2) + 1) * src_size * 65536) / ((int64_t)dst_size * 2) - 32768;
+
+    if (pos < 0) {
+        pos = 0;
+    }
+    if (pos > ((int64_t)(src_size - 1) * 65536)) {
+        pos = (int64_t)(src_size - 1) * 65536;
+    }
+    return (int32_t)pos;
+}
+
+void resize_bilinear_begin(const image_view_t * p_src, const image_view_t * p_dst) {
+    src_view = *p_src;
+    dst_view = *p_dst;
+    for (uint32_t x = 0; x < p_dst->width; x++) {
+        int32_t pos = map_pos(x, p_src->width, p_dst->width);
+
+        x_pos[x]  = pos >> 16;
+        x_frac[x] = (pos >> (16 - FRAC_BITS)) & (FRAC_ONE - 1);
+    }
+}
+
+void resize_bilinear_stripe(uint32_t dst_top, uint32_t dst_end) {
+    for (uint32_t y = dst_top; y < dst_end; y++) {
+        int32_t  pos = map_pos(y, src_view.height, dst_view.height);
+        uint32_t y0 = pos >> 16;
+        uint32_t y1 = (y0 + 1 < src_view.height) ? (y0 + 1) : y0;
+        uint32_t wy = (pos >> (16 - FRAC_BITS)) & (FRAC_ONE - 1);
+        const uint8_t * p_row0 = image_view_row(&src_view, y0);
+        const uint8_t * p_row1 = image_view_row(&src_view, y1);
+        uint8_t * p_out = image_view_row(&dst_view, y);
+
+        for (uint32_t x = 0; x < dst_view.width; x++) {
+            uint32_t x0 = x_pos[x];
+            uint32_t x1 = (x0 + 1 < src_view.width) ? (x0 + 1) : x0;
+            uint32_t wx = x_frac[x];
+            uint32_t top = (p_row0[x0] * (FRAC_ONE - wx)) + (p_row0[x1] * wx);
+            uint32_t bottom = (p_row1[x0] * (FRAC_ONE - wx)) + (p_row1[x1] * wx);
+
+            p_out[x] = ((top * (FRAC_ONE - wy)) + (bottom * wy) + (1 << ((FRAC_BITS * 2) - 1))) >> (FRAC_BITS * 2);
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef RESIZE_BILINEAR_H
+#define RESIZE_BILINEAR_H
+
+#include <stdint.h>
+#include "image_view.h"
+
+/*! Fixed-point bilinear resize for ratios that the DRP library cannot express.
+    The scale factor is dst size / src size, so any rational factor up or down
+    is supported. The output is produced in horizontal stripes; each stripe
+    reads the source rows it needs directly from the (strided) source view. */
+
+#define RESIZE_WIDTH_MAX       (1280)
+
+/* Prepares the horizontal sampling table for a src/dst pair. The dst width is at most RESIZE_WIDTH_MAX. */
+extern void resize_bilinear_begin(const image_view_t * p_src, const image_view_t * p_dst);
+
+/* Produces dst rows [dst_top, dst_end). */
+extern void resize_bilinear_stripe(uint32_t dst_top, uint32_t dst_end);
+
+#endif
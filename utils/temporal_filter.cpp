@@ -0,0 +1,195 @@
+#include "mbed.h"
+#include "temporal_filter.h"
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TEMPORAL_USE_NEON      (1)
+#endif
+
+static inline uint8_t sat_output(uint32_t value) {
+    value <<= TEMPORAL_OUTPUT_SHIFT;
+    return (value > 255) ? 255 : value;
+}
+
+void temporal_init(temporal_state_t * p_state, uint8_t * p_buf, uint32_t width, uint32_t height) {
+    p_state->p_state = p_buf;
+    p_state->width   = width;
+    p_state->height  = height;
+    p_state->primed  = false;
+}
+
+void temporal_frame_end(temporal_state_t * p_state) {
+    p_state->primed = true;
+}
+
+//
+// Running average
+//
+static void running_average_row(uint16_t * p_mean, const uint8_t * p_src, uint8_t * p_dst, uint32_t width) {
+    uint32_t x = 0;
+
+    // mean - mean / 2^s + src * 2^(8 - s) keeps a Q8.8 mean that settles exactly on a still pixel
+#if TEMPORAL_USE_NEON
+    for (; (x + 8) <= width; x += 8) {
+        uint16x8_t mean = vld1q_u16(&p_mean[x]);
+
+        mean = vsubq_u16(mean, vshrq_n_u16(mean, TEMPORAL_AVERAGE_SHIFT));
+        mean = vaddq_u16(mean, vshll_n_u8(vld1_u8(&p_src[x]), 8 - TEMPORAL_AVERAGE_SHIFT));
+        vst1q_u16(&p_mean[x], mean);
+        vst1_u8(&p_dst[x], vrshrn_n_u16(mean, 8));
+    }
+#endif
+    for (; x < width; x++) {
+        uint32_t mean = p_mean[x];
+
+        mean = mean - (mean >> TEMPORAL_AVERAGE_SHIFT) + ((uint32_t)p_src[x] << (8 - TEMPORAL_AVERAGE_SHIFT));
+        p_mean[x] = mean;
+        p_dst[x] = (mean + 128) >> 8;
+    }
+}
+
+void temporal_running_average(temporal_state_t * p_state, const image_view_t * p_src, const image_view_t * p_dst,
+                              uint32_t top, uint32_t rows) {
+    uint16_t * p_mean = (uint16_t *)p_state->p_state;
+    uint32_t width = p_state->width;
+
+    for (uint32_t y = top; y < (top + rows); y++) {
+        const uint8_t * p_in = image_view_row(p_src, y);
+        uint8_t * p_out = image_view_row(p_dst, y);
+        uint16_t * p_row = &p_mean[y * width];
+
+        if (!p_state->primed) {
+            for (uint32_t x = 0; x < width; x++) {
+                p_row[x] = (uint16_t)p_in[x] << 8;
+            }
+        }
+        running_average_row(p_row, p_in, p_out, width);
+    }
+}
+
+//
+// Sigma-delta background model
+//
+static void background_row(uint8_t * p_mean, uint8_t * p_var, const uint8_t * p_src, uint8_t * p_dst, uint32_t width) {
+    uint32_t x = 0;
+
+#if TEMPORAL_USE_NEON
+    const uint8x16_t var_min = vdupq_n_u8(TEMPORAL_BG_VAR_MIN);
+
+    for (; (x + 16) <= width; x += 16) {
+        uint8x16_t src  = vld1q_u8(&p_src[x]);
+        uint8x16_t mean = vld1q_u8(&p_mean[x]);
+        uint8x16_t var  = vld1q_u8(&p_var[x]);
+        uint8x16_t diff;
+        uint8x16_t n_diff;
+        uint8x16_t active;
+        uint8x16_t lt;
+        uint8x16_t gt;
+
+        // Comparison masks are 0xFF (-1), so subtracting "less than" steps up and adding "greater than" steps down
+        lt   = vcltq_u8(mean, src);
+        gt   = vcgtq_u8(mean, src);
+        mean = vaddq_u8(vsubq_u8(mean, lt), gt);
+        diff = vabdq_u8(src, mean);
+
+        n_diff = diff;
+        for (uint32_t n = 1; n < TEMPORAL_BG_N; n++) {
+            n_diff = vqaddq_u8(n_diff, diff);
+        }
+        active = vtstq_u8(diff, diff);
+        lt  = vandq_u8(vcltq_u8(var, n_diff), active);
+        gt  = vandq_u8(vcgtq_u8(var, n_diff), active);
+        var = vmaxq_u8(vaddq_u8(vsubq_u8(var, lt), gt), var_min);
+
+        vst1q_u8(&p_mean[x], mean);
+        vst1q_u8(&p_var[x], var);
+        vst1q_u8(&p_dst[x], vqshlq_n_u8(vqsubq_u8(diff, var), TEMPORAL_OUTPUT_SHIFT));
+    }
+#endif
+    for (; x < width; x++) {
+        uint32_t src  = p_src[x];
+        uint32_t mean = p_mean[x];
+        uint32_t var  = p_var[x];
+        uint32_t diff;
+        uint32_t n_diff;
+
+        if (mean < src) {
+            mean++;
+        } else if (mean > src) {
+            mean--;
+        }
+        diff = (src > mean) ? (src - mean) : (mean - src);
+        n_diff = diff * TEMPORAL_BG_N;
+        if (n_diff > 255) {
+            n_diff = 255;
+        }
+        if (diff != 0) {
+            if (var < n_diff) {
+                var++;
+            } else if (var > n_diff) {
+                var--;
+            }
+        }
+        if (var < TEMPORAL_BG_VAR_MIN) {
+            var = TEMPORAL_BG_VAR_MIN;
+        }
+        p_mean[x] = mean;
+        p_var[x]  = var;
+        p_dst[x]  = (diff > var) ? sat_output(diff - var) : 0;
+    }
+}
+
+void temporal_background(temporal_state_t * p_state, const image_view_t * p_src, const image_view_t * p_dst,
+                         uint32_t top, uint32_t rows) {
+    uint32_t width = p_state->width;
+    uint8_t * p_mean = p_state->p_state;
+    uint8_t * p_var  = p_mean + (width * p_state->height);
+
+    for (uint32_t y = top; y < (top + rows); y++) {
+        const uint8_t * p_in = image_view_row(p_src, y);
+        uint8_t * p_out = image_view_row(p_dst, y);
+
+        if (!p_state->primed) {
+            memcpy(&p_mean[y * width], p_in, width);
+            memset(&p_var[y * width], TEMPORAL_BG_VAR_MIN, width);
+        }
+        background_row(&p_mean[y * width], &p_var[y * width], p_in, p_out, width);
+    }
+}
+
+//
+// Frame difference
+//
+static void frame_diff_row(uint8_t * p_prev, const uint8_t * p_src, uint8_t * p_dst, uint32_t width) {
+    uint32_t x = 0;
+
+#if TEMPORAL_USE_NEON
+    for (; (x + 16) <= width; x += 16) {
+        uint8x16_t src = vld1q_u8(&p_src[x]);
+
+        vst1q_u8(&p_dst[x], vqshlq_n_u8(vabdq_u8(src, vld1q_u8(&p_prev[x])), TEMPORAL_OUTPUT_SHIFT));
+        vst1q_u8(&p_prev[x], src);
+    }
+#endif
+    for (; x < width; x++) {
+        uint32_t src  = p_src[x];
+        uint32_t prev = p_prev[x];
+
+        p_dst[x]  = sat_output((src > prev) ? (src - prev) : (prev - src));
+        p_prev[x] = src;
+    }
+}
+
+void temporal_frame_diff(temporal_state_t * p_state, const image_view_t * p_src, const image_view_t * p_dst,
+                         uint32_t top, uint32_t rows) {
+    uint32_t width = p_state->width;
+    uint8_t * p_prev = p_state->p_state;
+
+    for (uint32_t y = top; y < (top + rows); y++) {
+        const uint8_t * p_in = image_view_row(p_src, y);
+
+        if (!p_state->primed) {
+            memcpy(&p_prev[y * width], p_in, width);
+        }
+        frame_diff_row(&p_prev[y * width], p_in, image_view_row(p_dst, y), width);
+    }
+}
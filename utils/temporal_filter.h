@@ -0,0 +1,49 @@
+#ifndef TEMPORAL_FILTER_H
+#define TEMPORAL_FILTER_H
+
+#include <stdint.h>
+#include "image_view.h"
+
+/*! Temporal filters that carry per-pixel state from one frame to the next.
+    The state is kept in a packed fixed-point buffer owned by the caller and
+    is updated in place, one stripe of rows at a time, so the filters run on
+    the same stripe partition as the DRP libraries. The first frame after
+    temporal_init() seeds the state and produces a neutral output. */
+
+#define TEMPORAL_AVERAGE_SHIFT  (4)     /* Running average weight of the new frame: 1 / 2^4 */
+#define TEMPORAL_BG_N           (2)     /* Background variance tracks N times the deviation */
+#define TEMPORAL_BG_VAR_MIN     (2)     /* Lower bound of the background variance */
+#define TEMPORAL_OUTPUT_SHIFT   (2)     /* Gain of the difference outputs (saturated to 255) */
+
+/* Bytes of state per pixel */
+#define TEMPORAL_AVERAGE_BPP    (2)     /* Q8.8 mean */
+#define TEMPORAL_BG_BPP         (2)     /* Mean plane followed by a variance plane */
+#define TEMPORAL_DIFF_BPP       (1)     /* Previous frame */
+
+typedef struct {
+    uint8_t * p_state;
+    uint16_t  width;
+    uint16_t  height;
+    bool      primed;       /* false until a whole frame has seeded the state */
+} temporal_state_t;
+
+/* Binds a state buffer of width * height * bpp bytes. The next frame reseeds it. */
+extern void temporal_init(temporal_state_t * p_state, uint8_t * p_buf, uint32_t width, uint32_t height);
+
+/* Marks the state as seeded once every stripe of a frame has been processed. */
+extern void temporal_frame_end(temporal_state_t * p_state);
+
+/* Exponential running average: mean += (src - mean) / 2^TEMPORAL_AVERAGE_SHIFT, dst = mean. */
+extern void temporal_running_average(temporal_state_t * p_state, const image_view_t * p_src, const image_view_t * p_dst,
+                                     uint32_t top, uint32_t rows);
+
+/* Sigma-delta background model. The mean and the variance move by one step per frame;
+   dst = (|src - mean| - variance) << TEMPORAL_OUTPUT_SHIFT, which is non-zero on foreground. */
+extern void temporal_background(temporal_state_t * p_state, const image_view_t * p_src, const image_view_t * p_dst,
+                                uint32_t top, uint32_t rows);
+
+/* Absolute frame difference: dst = |src - previous| << TEMPORAL_OUTPUT_SHIFT. */
+extern void temporal_frame_diff(temporal_state_t * p_state, const image_view_t * p_src, const image_view_t * p_dst,
+                                uint32_t top, uint32_t rows);
+
+#endif